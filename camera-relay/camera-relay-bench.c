@@ -0,0 +1,685 @@
+/*
+ * camera-relay-bench — glass-to-glass benchmark for the camera relay
+ *
+ * Measures what the relay actually delivers to a client: end-to-end
+ * latency, frame-interval jitter, sustained throughput, and the START
+ * latency of the IDLE→RELAY transition. Nothing is mocked — the real
+ * camera-relay-monitor runs against a real v4l2loopback device, with
+ * this tool standing in for both ends of the path:
+ *
+ *   produce  — pipeline stand-in. Writes test-pattern frames to fd 3
+ *              (the monitor's frame sink, same contract as the
+ *              gst-launch fdsink) at a fixed rate, stamping a magic,
+ *              a sequence number and a CLOCK_MONOTONIC timestamp into
+ *              the first bytes of every frame.
+ *
+ *   consume  — client stand-in. Opens the loopback device like any
+ *              capture application (MMAP streaming, read() fallback),
+ *              which is exactly what flips the monitor from IDLE to
+ *              RELAY. Decodes the stamps and reports latency
+ *              percentiles, interval jitter, throughput and gaps.
+ *
+ *   run      — orchestrates a full cycle: starts the monitor with
+ *              `produce` as its pipeline command, waits for READY,
+ *              connects a consumer, and echoes the monitor's
+ *              READY/START/STOP/STATS lines with relative timestamps
+ *              so transition costs line up with the consumer's
+ *              numbers.
+ *
+ * Latency here is producer-stamp to consumer-DQBUF on one host and
+ * one clock, so it covers the pipe hop, the monitor's relay write and
+ * the v4l2loopback handoff — everything the relay is responsible for,
+ * without the sensor exposure time.
+ *
+ * Build:  gcc -O2 -Wall -o camera-relay-bench camera-relay-bench.c
+ * (or `make` next to the monitor)
+ *
+ * Typical use (device must be a v4l2loopback output, see README):
+ *   ./camera-relay-bench run /dev/video9 1280 720 --seconds=20
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MAGIC	0x68636e62	/* "bnch" */
+#define SINK_FD		3		/* monitor's frame sink fd */
+#define MAX_SAMPLES	262144		/* ~2.4h at 30fps */
+
+/*
+ * Frame stamp, written over the first pixels of every produced frame.
+ * Raw little-endian bytes: the relay treats frames as opaque byte
+ * streams (no --convert in bench runs), so the stamp arrives intact.
+ */
+struct bench_stamp {
+	uint32_t magic;
+	uint32_t seq;
+	uint64_t t_ns;		/* CLOCK_MONOTONIC at send */
+} __attribute__((packed));
+
+static volatile sig_atomic_t running = 1;
+
+static void handle_signal(int sig)
+{
+	(void)sig;
+	running = 0;
+}
+
+static long long now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int xioctl(int fd, unsigned long request, void *arg)
+{
+	int r;
+	do {
+		r = ioctl(fd, request, arg);
+	} while (r == -1 && errno == EINTR && running);
+	return r;
+}
+
+/* ──────────────────────── producer ──────────────────────── */
+
+/*
+ * Test pattern: gray gradient with a white bar sweeping one row per
+ * frame, so a human can eyeball the stream while the stamps do the
+ * measuring. YUY2 only — the bench exercises the relay path, not the
+ * format matrix.
+ */
+static void fill_pattern(char *buf, int width, int height, uint32_t seq)
+{
+	int stride = width * 2;
+	int bar = (int)(seq % (uint32_t)height);
+
+	for (int y = 0; y < height; y++) {
+		char *row = buf + y * stride;
+		char luma = (y == bar) ? (char)0xeb
+				       : (char)(0x20 + (y * 0x80) / height);
+		for (int x = 0; x < stride; x += 2) {
+			row[x] = luma;
+			row[x + 1] = (char)0x80;
+		}
+	}
+}
+
+static int write_full(int fd, const char *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t n = write(fd, buf, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		buf += n;
+		len -= (size_t)n;
+	}
+	return 0;
+}
+
+static int cmd_produce(int argc, char *argv[])
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: produce <width> <height> [fps]\n");
+		return 1;
+	}
+	int width = atoi(argv[0]);
+	int height = atoi(argv[1]);
+	int fps = (argc > 2) ? atoi(argv[2]) : 30;
+	if (width <= 0 || height <= 0 || fps <= 0) {
+		fprintf(stderr, "[produce] Bad geometry/rate\n");
+		return 1;
+	}
+
+	/* Run as the monitor's pipeline child (sink on fd 3) or
+	 * standalone on stdout for manual piping. */
+	int out_fd = SINK_FD;
+	if (fcntl(out_fd, F_GETFD) < 0)
+		out_fd = STDOUT_FILENO;
+
+	int frame_size = width * height * 2;
+	char *frame = malloc(frame_size);
+	if (!frame) {
+		fprintf(stderr, "[produce] Cannot allocate frame\n");
+		return 1;
+	}
+
+	signal(SIGINT, handle_signal);
+	signal(SIGTERM, handle_signal);
+	signal(SIGPIPE, SIG_IGN);
+
+	/*
+	 * Absolute-time pacing: each deadline is the previous one plus
+	 * the period, so jitter doesn't accumulate. If a write blocks
+	 * past a deadline (consumer stall), skip the sleep but keep the
+	 * grid — the consumer sees the stall as latency, which is the
+	 * point.
+	 */
+	long long period = 1000000000LL / fps;
+	struct timespec next;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	uint32_t seq = 0;
+	while (running) {
+		fill_pattern(frame, width, height, seq);
+
+		struct bench_stamp stamp = {
+			.magic = BENCH_MAGIC,
+			.seq = seq,
+			.t_ns = (uint64_t)now_ns(),
+		};
+		memcpy(frame, &stamp, sizeof(stamp));
+
+		if (write_full(out_fd, frame, frame_size) < 0)
+			break;	/* monitor closed the pipe: clean stop */
+		seq++;
+
+		next.tv_nsec += period;
+		while (next.tv_nsec >= 1000000000L) {
+			next.tv_nsec -= 1000000000L;
+			next.tv_sec++;
+		}
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (now.tv_sec > next.tv_sec ||
+		    (now.tv_sec == next.tv_sec &&
+		     now.tv_nsec > next.tv_nsec)) {
+			next = now;	/* behind: reset the grid */
+			continue;
+		}
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+				       &next, NULL) == EINTR && running)
+			;
+	}
+
+	fprintf(stderr, "[produce] Sent %u frames\n", seq);
+	free(frame);
+	return 0;
+}
+
+/* ──────────────────────── consumer ──────────────────────── */
+
+static int cmp_double(const void *a, const void *b)
+{
+	double da = *(const double *)a, db = *(const double *)b;
+	return (da > db) - (da < db);
+}
+
+/* Percentile over a sorted sample array. */
+static double pctile(const double *sorted, int n, double p)
+{
+	if (n <= 0)
+		return 0.0;
+	int idx = (int)(p * (n - 1) + 0.5);
+	return sorted[idx];
+}
+
+struct cap_buf {
+	void *start;
+	size_t length;
+};
+
+static int cmd_consume(int argc, char *argv[])
+{
+	if (argc < 3) {
+		fprintf(stderr,
+			"Usage: consume <device> <width> <height>"
+			" [--seconds=S]\n");
+		return 1;
+	}
+	const char *device = argv[0];
+	int width = atoi(argv[1]);
+	int height = atoi(argv[2]);
+	int seconds = 10;
+	for (int i = 3; i < argc; i++) {
+		if (strncmp(argv[i], "--seconds=", 10) == 0)
+			seconds = atoi(argv[i] + 10);
+	}
+	int frame_size = width * height * 2;
+
+	signal(SIGINT, handle_signal);
+	signal(SIGTERM, handle_signal);
+
+	long long t_open = now_ns();
+	int fd = open(device, O_RDWR);
+	if (fd < 0) {
+		fprintf(stderr, "[consume] Cannot open %s: %s\n",
+			device, strerror(errno));
+		return 1;
+	}
+
+	/* Negotiate like a normal client: take the writer's format and
+	 * sanity-check the geometry. */
+	struct v4l2_format fmt;
+	memset(&fmt, 0, sizeof(fmt));
+	fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	if (xioctl(fd, VIDIOC_G_FMT, &fmt) < 0) {
+		fprintf(stderr, "[consume] G_FMT failed: %s\n",
+			strerror(errno));
+		close(fd);
+		return 1;
+	}
+	if ((int)fmt.fmt.pix.width != width ||
+	    (int)fmt.fmt.pix.height != height)
+		fprintf(stderr,
+			"[consume] Device is %ux%u, expected %dx%d —"
+			" stamps may not decode\n",
+			fmt.fmt.pix.width, fmt.fmt.pix.height,
+			width, height);
+
+	/* MMAP streaming I/O, read() fallback for loopback builds
+	 * without capture-side REQBUFS. */
+	struct cap_buf bufs[4];
+	int n_bufs = 0;
+	struct v4l2_requestbuffers req;
+	memset(&req, 0, sizeof(req));
+	req.count = 4;
+	req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	req.memory = V4L2_MEMORY_MMAP;
+	if (xioctl(fd, VIDIOC_REQBUFS, &req) == 0 && req.count > 0) {
+		for (unsigned int i = 0; i < req.count && i < 4; i++) {
+			struct v4l2_buffer b;
+			memset(&b, 0, sizeof(b));
+			b.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			b.memory = V4L2_MEMORY_MMAP;
+			b.index = i;
+			if (xioctl(fd, VIDIOC_QUERYBUF, &b) < 0)
+				break;
+			bufs[i].length = b.length;
+			bufs[i].start = mmap(NULL, b.length,
+					     PROT_READ, MAP_SHARED,
+					     fd, b.m.offset);
+			if (bufs[i].start == MAP_FAILED)
+				break;
+			n_bufs++;
+			if (xioctl(fd, VIDIOC_QBUF, &b) < 0) {
+				fprintf(stderr,
+					"[consume] QBUF failed: %s\n",
+					strerror(errno));
+				break;
+			}
+		}
+	}
+	char *read_buf = NULL;
+	if (n_bufs > 0) {
+		enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		if (xioctl(fd, VIDIOC_STREAMON, &type) < 0) {
+			fprintf(stderr, "[consume] STREAMON failed: %s\n",
+				strerror(errno));
+			close(fd);
+			return 1;
+		}
+		fprintf(stderr, "[consume] MMAP streaming, %d buffers\n",
+			n_bufs);
+	} else {
+		read_buf = malloc(frame_size);
+		if (!read_buf) {
+			close(fd);
+			return 1;
+		}
+		fprintf(stderr, "[consume] read() I/O\n");
+	}
+
+	double *lat = malloc(MAX_SAMPLES * sizeof(double));
+	double *ivl = malloc(MAX_SAMPLES * sizeof(double));
+	if (!lat || !ivl) {
+		fprintf(stderr, "[consume] Cannot allocate samples\n");
+		free(lat);
+		free(ivl);
+		close(fd);
+		return 1;
+	}
+	int n_lat = 0, n_ivl = 0;
+
+	long long t_first_frame = 0;	/* any frame (black counts) */
+	long long t_first_real = 0;	/* first stamped frame */
+	long long t_prev_real = 0;
+	long long deadline = 0;
+	uint32_t first_seq = 0, last_seq = 0;
+	long frames = 0, real_frames = 0, gaps = 0, lost = 0;
+
+	while (running) {
+		struct pollfd pfd = { .fd = fd, .events = POLLIN };
+		int pr = poll(&pfd, 1, 2000);
+		if (pr < 0 && errno == EINTR)
+			continue;
+		if (pr <= 0) {
+			/* Waiting for the pipeline to come up is
+			 * normal; an established stream going quiet
+			 * is the end of the run. */
+			if (t_first_real)
+				break;
+			if (now_ns() - t_open > 30000000000LL) {
+				fprintf(stderr, "[consume] No stamped"
+					" frames after 30s, giving up\n");
+				break;
+			}
+			continue;
+		}
+
+		const char *data;
+		struct v4l2_buffer vbuf;
+		if (n_bufs > 0) {
+			memset(&vbuf, 0, sizeof(vbuf));
+			vbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			vbuf.memory = V4L2_MEMORY_MMAP;
+			if (xioctl(fd, VIDIOC_DQBUF, &vbuf) < 0) {
+				if (errno == EAGAIN)
+					continue;
+				fprintf(stderr,
+					"[consume] DQBUF failed: %s\n",
+					strerror(errno));
+				break;
+			}
+			data = bufs[vbuf.index].start;
+		} else {
+			ssize_t n = read(fd, read_buf, frame_size);
+			if (n < 0) {
+				if (errno == EINTR || errno == EAGAIN)
+					continue;
+				fprintf(stderr,
+					"[consume] read failed: %s\n",
+					strerror(errno));
+				break;
+			}
+			data = read_buf;
+		}
+
+		long long t = now_ns();
+		frames++;
+		if (!t_first_frame)
+			t_first_frame = t;
+
+		struct bench_stamp stamp;
+		memcpy(&stamp, data, sizeof(stamp));
+		if (stamp.magic == BENCH_MAGIC) {
+			if (!t_first_real) {
+				t_first_real = t;
+				first_seq = stamp.seq;
+				deadline = t +
+					(long long)seconds * 1000000000LL;
+			} else {
+				if (n_ivl < MAX_SAMPLES)
+					ivl[n_ivl++] =
+						(t - t_prev_real) / 1e6;
+				if (stamp.seq > last_seq + 1) {
+					gaps++;
+					lost += stamp.seq - last_seq - 1;
+				}
+			}
+			t_prev_real = t;
+			last_seq = stamp.seq;
+			real_frames++;
+			if (n_lat < MAX_SAMPLES)
+				lat[n_lat++] =
+					(t - (long long)stamp.t_ns) / 1e6;
+		}
+
+		if (n_bufs > 0 && xioctl(fd, VIDIOC_QBUF, &vbuf) < 0) {
+			fprintf(stderr, "[consume] QBUF failed: %s\n",
+				strerror(errno));
+			break;
+		}
+
+		if (deadline && t >= deadline)
+			break;
+	}
+
+	/* ── Report ── */
+	if (!t_first_real) {
+		fprintf(stderr, "[consume] Never saw a stamped frame"
+			" (%ld frames total)\n", frames);
+	} else {
+		double span_s = (t_prev_real - t_first_real) / 1e9;
+
+		printf("BENCH start first_frame_ms=%.1f"
+		       " first_real_ms=%.1f\n",
+		       (t_first_frame - t_open) / 1e6,
+		       (t_first_real - t_open) / 1e6);
+
+		qsort(lat, n_lat, sizeof(double), cmp_double);
+		printf("BENCH latency_ms n=%d p50=%.2f p90=%.2f"
+		       " p99=%.2f max=%.2f\n",
+		       n_lat, pctile(lat, n_lat, 0.50),
+		       pctile(lat, n_lat, 0.90),
+		       pctile(lat, n_lat, 0.99),
+		       pctile(lat, n_lat, 1.0));
+
+		double mean = 0.0, var = 0.0;
+		for (int i = 0; i < n_ivl; i++)
+			mean += ivl[i];
+		if (n_ivl > 0)
+			mean /= n_ivl;
+		for (int i = 0; i < n_ivl; i++)
+			var += (ivl[i] - mean) * (ivl[i] - mean);
+		if (n_ivl > 1)
+			var /= n_ivl - 1;
+		qsort(ivl, n_ivl, sizeof(double), cmp_double);
+		printf("BENCH interval_ms n=%d mean=%.2f jitter=%.2f"
+		       " p99=%.2f max=%.2f\n",
+		       n_ivl, mean, sqrt(var),
+		       pctile(ivl, n_ivl, 0.99),
+		       pctile(ivl, n_ivl, 1.0));
+
+		printf("BENCH throughput frames=%ld fps=%.2f gaps=%ld"
+		       " lost=%ld span=%u\n",
+		       real_frames,
+		       span_s > 0.0 ? (real_frames - 1) / span_s : 0.0,
+		       gaps, lost, last_seq - first_seq + 1);
+	}
+
+	if (n_bufs > 0) {
+		enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		xioctl(fd, VIDIOC_STREAMOFF, &type);
+		for (int i = 0; i < n_bufs; i++)
+			munmap(bufs[i].start, bufs[i].length);
+	}
+	free(read_buf);
+	free(lat);
+	free(ivl);
+	close(fd);
+	return t_first_real ? 0 : 1;
+}
+
+/* ──────────────────────── orchestrator ──────────────────────── */
+
+static int cmd_run(int argc, char *argv[])
+{
+	if (argc < 3) {
+		fprintf(stderr,
+			"Usage: run <device> <width> <height>"
+			" [--seconds=S] [--fps=N] [--monitor=PATH]"
+			" [-- <extra monitor options>]\n");
+		return 1;
+	}
+	const char *device = argv[0];
+	const char *w = argv[1], *h = argv[2];
+	const char *monitor = "./camera-relay-monitor";
+	int seconds = 10, fps = 30;
+	char **extra = NULL;
+	int n_extra = 0;
+	for (int i = 3; i < argc; i++) {
+		if (strncmp(argv[i], "--seconds=", 10) == 0) {
+			seconds = atoi(argv[i] + 10);
+			continue;
+		}
+		if (strncmp(argv[i], "--fps=", 6) == 0) {
+			fps = atoi(argv[i] + 6);
+			continue;
+		}
+		if (strncmp(argv[i], "--monitor=", 10) == 0) {
+			monitor = argv[i] + 10;
+			continue;
+		}
+		if (strcmp(argv[i], "--") == 0) {
+			extra = &argv[i + 1];
+			n_extra = argc - i - 1;
+			break;
+		}
+	}
+
+	/* Our own path, for the monitor's pipeline command and the
+	 * consumer child. */
+	char self[4096];
+	ssize_t sn = readlink("/proc/self/exe", self, sizeof(self) - 1);
+	if (sn < 0) {
+		fprintf(stderr, "[run] readlink /proc/self/exe: %s\n",
+			strerror(errno));
+		return 1;
+	}
+	self[sn] = '\0';
+
+	char fps_str[16];
+	snprintf(fps_str, sizeof(fps_str), "%d", fps);
+
+	/* monitor <dev> <w> <h> [extra...] -- self produce <w> <h> <fps> */
+	const char *margv[32];
+	int m = 0;
+	margv[m++] = monitor;
+	margv[m++] = device;
+	margv[m++] = w;
+	margv[m++] = h;
+	for (int i = 0; i < n_extra && m < 24; i++)
+		margv[m++] = extra[i];
+	margv[m++] = "--";
+	margv[m++] = self;
+	margv[m++] = "produce";
+	margv[m++] = w;
+	margv[m++] = h;
+	margv[m++] = fps_str;
+	margv[m] = NULL;
+
+	signal(SIGINT, handle_signal);
+	signal(SIGTERM, handle_signal);
+
+	int mon_out[2];
+	if (pipe(mon_out) < 0) {
+		fprintf(stderr, "[run] pipe: %s\n", strerror(errno));
+		return 1;
+	}
+
+	pid_t mon_pid = fork();
+	if (mon_pid < 0) {
+		fprintf(stderr, "[run] fork: %s\n", strerror(errno));
+		return 1;
+	}
+	if (mon_pid == 0) {
+		close(mon_out[0]);
+		dup2(mon_out[1], STDOUT_FILENO);
+		close(mon_out[1]);
+		execvp(margv[0], (char * const *)margv);
+		fprintf(stderr, "[run] exec %s: %s\n", margv[0],
+			strerror(errno));
+		_exit(127);
+	}
+	close(mon_out[1]);
+
+	/*
+	 * Echo monitor events with timestamps relative to READY, then
+	 * connect the consumer: the gap between the consumer child
+	 * starting and the monitor's START line is the detection cost,
+	 * and the consumer's first_real_ms is the full IDLE→RELAY
+	 * transition as a client experiences it.
+	 */
+	FILE *mf = fdopen(mon_out[0], "r");
+	long long t_ready = 0;
+	pid_t con_pid = 0;
+	int con_status = -1;
+	char line[512];
+
+	while (running && fgets(line, sizeof(line), mf)) {
+		line[strcspn(line, "\n")] = '\0';
+		if (t_ready)
+			printf("+%7.3fs [monitor] %s\n",
+			       (now_ns() - t_ready) / 1e9, line);
+		else
+			printf("         [monitor] %s\n", line);
+		fflush(stdout);
+
+		if (!t_ready && strcmp(line, "READY") == 0) {
+			t_ready = now_ns();
+			con_pid = fork();
+			if (con_pid == 0) {
+				fclose(mf);
+				char secs[32];
+				snprintf(secs, sizeof(secs),
+					 "--seconds=%d", seconds);
+				execl(self, self, "consume", device,
+				      w, h, secs, (char *)NULL);
+				_exit(127);
+			}
+		}
+
+		/* Stop following the monitor once the consumer is done;
+		 * a non-blocking check each line keeps this simple. */
+		if (con_pid > 0 &&
+		    waitpid(con_pid, &con_status, WNOHANG) == con_pid) {
+			con_pid = 0;
+			break;
+		}
+	}
+
+	if (con_pid > 0)
+		waitpid(con_pid, &con_status, 0);
+
+	kill(mon_pid, SIGTERM);
+	for (int i = 0; i < 30; i++) {
+		if (waitpid(mon_pid, NULL, WNOHANG) != 0)
+			break;
+		usleep(100000);
+		if (i == 29) {
+			kill(mon_pid, SIGKILL);
+			waitpid(mon_pid, NULL, 0);
+		}
+	}
+	fclose(mf);
+
+	if (!t_ready) {
+		fprintf(stderr, "[run] Monitor never reported READY\n");
+		return 1;
+	}
+	return (con_status >= 0 && WIFEXITED(con_status)) ?
+		WEXITSTATUS(con_status) : 1;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		fprintf(stderr,
+			"Usage: %s produce|consume|run ...\n"
+			"  produce <width> <height> [fps]\n"
+			"  consume <device> <width> <height> [--seconds=S]\n"
+			"  run <device> <width> <height> [--seconds=S]"
+			" [--fps=N] [--monitor=PATH]"
+			" [-- <extra monitor options>]\n",
+			argv[0]);
+		return 1;
+	}
+	setvbuf(stdout, NULL, _IOLBF, 0);
+
+	if (strcmp(argv[1], "produce") == 0)
+		return cmd_produce(argc - 2, argv + 2);
+	if (strcmp(argv[1], "consume") == 0)
+		return cmd_consume(argc - 2, argv + 2);
+	if (strcmp(argv[1], "run") == 0)
+		return cmd_run(argc - 2, argv + 2);
+
+	fprintf(stderr, "Unknown command '%s'\n", argv[1]);
+	return 1;
+}
@@ -17,9 +17,58 @@
  *   READY  — device open, watching for clients
  *   START  — client detected, pipeline starting
  *   STOP   — clients gone, pipeline stopped
+ *   RESTART — pipeline failed or stalled; retrying after the
+ *            reported backoff delay
+ *   STATS  — telemetry snapshot every 10s, key=value pairs (frame
+ *            and drop counters, device-write latency percentiles,
+ *            /proc scan cost, restart count)
+ *
+ * The same events are also pushed as fixed-size binary structs over a
+ * unix SOCK_SEQPACKET socket at $XDG_RUNTIME_DIR/camera-relay-events
+ * (struct relay_event below, one datagram per event), so the systray
+ * and fleet tooling get state transitions and counters without
+ * tailing stdout or parsing lines. stdout stays reserved for the
+ * systemd journal.
  *
  * Build:  gcc -O2 -Wall -o camera-relay-monitor camera-relay-monitor.c
- * Usage:  camera-relay-monitor /dev/video0 1920 1080 -- gst-launch-1.0 ...
+ *
+ * Build with embedded-pipeline support (in-process GStreamer, no
+ * fork/exec of gst-launch-1.0 per client connect):
+ *   gcc -O2 -Wall -DHAVE_GST \
+ *       $(pkg-config --cflags gstreamer-1.0 gstreamer-app-1.0) \
+ *       -o camera-relay-monitor camera-relay-monitor.c \
+ *       $(pkg-config --libs gstreamer-1.0 gstreamer-app-1.0)
+ *
+ * Usage:  camera-relay-monitor /dev/video0 1920 1080
+ *             [--io=write|mmap|splice|uring]
+ *             [--embed] [--drop] [--standby=SEC]
+ *             [--format=yuy2|nv12|mjpeg] [--transport=pipe|shm]
+ *             [--mirror=DEV ...] [--convert=nv12-yuy2|uyvy-yuy2]
+ *             -- gst-launch-1.0 ...
+ *
+ * With --drop the relay keeps end-to-end latency bounded at one
+ * frame: when the consumer stalls and frames pile up in the pipe,
+ * intermediate frames are dropped so the newest complete frame wins.
+ * Drop totals are reported on stderr.
+ *
+ * With --standby=SEC the pipeline is kept hot for SEC seconds after
+ * the last client disconnects instead of being torn down — apps that
+ * probe the device and then immediately capture (the Cheese
+ * double-open pattern) resume real frames in well under 200ms
+ * instead of paying the 2-3s sensor/ISP bring-up again.
+ *
+ * With --io=mmap the monitor negotiates VIDIOC_REQBUFS/QBUF/DQBUF
+ * streaming I/O on the loopback writer fd and reads pipeline frames
+ * directly into the mapped kernel buffers, eliminating the
+ * intermediate relay-buffer copy (~one full 4MB memcpy per frame at
+ * 1080p). Falls back to the write() path automatically on
+ * v4l2loopback versions without output-side MMAP support.
+ *
+ * With --io=uring (pipe transport, raw formats) relayed frames ride
+ * an io_uring: linked read→write submissions on registered buffers,
+ * so each frame costs zero blocking syscalls and reading frame N+1
+ * overlaps writing frame N. Falls back to write() I/O on kernels
+ * without io_uring.
  */
 
 #define _GNU_SOURCE
@@ -29,15 +78,44 @@
 #include <linux/videodev2.h>
 #include <poll.h>
 #include <signal.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/sysmacros.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
+#ifdef HAVE_GST
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#endif
+
+/*
+ * io_uring relay datapath (--io=uring). Raw syscalls — no liburing
+ * dependency, matching the rest of this file. Compiled in only when
+ * the toolchain headers are recent enough for multishot poll
+ * (kernel 5.13 uapi); older kernels at runtime get a clean fallback
+ * to write() I/O from io_uring_setup() failing.
+ */
+#ifdef __NR_io_uring_setup
+#include <linux/io_uring.h>
+#endif
+#if defined(__NR_io_uring_setup) && defined(IORING_POLL_ADD_MULTI)
+#define HAVE_IO_URING 1
+#endif
+
 /* Event IDs for v4l2loopback versions */
 #define V4L2_EVENT_CLIENT_USAGE_OLD  (V4L2_EVENT_PRIVATE_START)
 #define V4L2_EVENT_CLIENT_USAGE_NEW  (V4L2_EVENT_PRIVATE_START + 0x08E00000 + 1)
@@ -59,6 +137,904 @@ static int xioctl(int fd, unsigned long request, void *arg)
 	return r;
 }
 
+/*
+ * Relay pixel formats.
+ *
+ * The device format is negotiated once via VIDIOC_S_FMT and the
+ * pipeline command is templated on it by the wrapper, so NV12-native
+ * consumers stop paying a redundant videoconvert inside GStreamer.
+ * MJPEG is relayed as a passthrough of complete JPEGs (frames are
+ * delimited by scanning for the EOI marker); it is compressed, so no
+ * idle black frame can be synthesized for it.
+ */
+struct relay_format {
+	const char *name;	/* --format= option value */
+	uint32_t fourcc;
+	int size_num, size_den;	/* frame bytes = w*h*num/den */
+	int compressed;		/* variable frame size, no idle frame */
+};
+
+static const struct relay_format relay_formats[] = {
+	{ "yuy2",  V4L2_PIX_FMT_YUYV,  2, 1, 0 },
+	{ "nv12",  V4L2_PIX_FMT_NV12,  3, 2, 0 },
+	{ "mjpeg", V4L2_PIX_FMT_MJPEG, 2, 1, 1 },  /* num/den = size cap */
+};
+
+static const struct relay_format *lookup_format(const char *name)
+{
+	for (size_t i = 0;
+	     i < sizeof(relay_formats) / sizeof(relay_formats[0]); i++)
+		if (strcmp(relay_formats[i].name, name) == 0)
+			return &relay_formats[i];
+	return NULL;
+}
+
+/* Fill buf with one black frame in the given format.
+ * (BT.601 black: Y=0x10, U=V=0x80.) */
+static void fill_black_frame(char *buf, const struct relay_format *f,
+			     int width, int height)
+{
+	switch (f->fourcc) {
+	case V4L2_PIX_FMT_YUYV:
+		for (int i = 0; i < width * height * 2; i += 4) {
+			buf[i + 0] = 0x10;
+			buf[i + 1] = (char)0x80;
+			buf[i + 2] = 0x10;
+			buf[i + 3] = (char)0x80;
+		}
+		break;
+	case V4L2_PIX_FMT_NV12:
+		memset(buf, 0x10, width * height);
+		memset(buf + width * height, 0x80, width * height / 2);
+		break;
+	default:
+		/* compressed formats have no synthetic black frame */
+		break;
+	}
+}
+
+
+/*
+ * In-monitor pixel conversion (--convert=nv12-yuy2|uyvy-yuy2).
+ *
+ * When consumers demand YUY2 but the camera's native output is NV12,
+ * GStreamer's generic videoconvert burns a surprising amount of CPU
+ * scalar-converting 1080p30. The monitor already owns the frame
+ * path, so it can run the pipeline in the sensor-native format and
+ * do the one needed conversion here at memory-bandwidth speed.
+ *
+ * NV12→YUY2 is a pure byte interleave: each YUY2 row is the Y row
+ * zipped with the corresponding (half-rate) UV row, so the kernel is
+ * unpacklo/unpackhi all the way down. UYVY→YUY2 is a byte swap
+ * within each 16-bit word. AVX2 and SSE2 variants are selected at
+ * startup via __builtin_cpu_supports(); the scalar path covers
+ * non-x86 builds.
+ */
+struct converter {
+	const char *name;	/* --convert= option value */
+	int in_num, in_den;	/* input frame bytes = w*h*num/den */
+	void (*fn)(char *dst, const char *src, int width, int height);
+};
+
+static void conv_nv12_scalar(char *dst, const char *src, int width,
+			     int height)
+{
+	const char *y = src;
+	const char *uv = src + (size_t)width * height;
+
+	for (int row = 0; row < height; row++) {
+		const char *u = uv + (size_t)(row / 2) * width;
+		for (int i = 0; i < width; i++) {
+			*dst++ = y[i];
+			*dst++ = u[i];
+		}
+		y += width;
+	}
+}
+
+static void conv_uyvy_scalar(char *dst, const char *src, int width,
+			     int height)
+{
+	size_t n = (size_t)width * height * 2;
+
+	for (size_t i = 0; i < n; i += 2) {
+		dst[i] = src[i + 1];
+		dst[i + 1] = src[i];
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+__attribute__((target("sse2")))
+static void conv_nv12_sse2(char *dst, const char *src, int width,
+			   int height)
+{
+	const __m128i *y = (const __m128i *)src;
+	const char *uvbase = src + (size_t)width * height;
+	int vecs = width / 16;	/* 1920 % 16 == 0 on every mode */
+
+	for (int row = 0; row < height; row++) {
+		const __m128i *uv = (const __m128i *)
+			(uvbase + (size_t)(row / 2) * width);
+		__m128i *out = (__m128i *)(dst +
+			(size_t)row * width * 2);
+		for (int i = 0; i < vecs; i++) {
+			__m128i vy = _mm_loadu_si128(y + i);
+			__m128i vuv = _mm_loadu_si128(uv + i);
+			_mm_storeu_si128(out + 2 * i,
+				_mm_unpacklo_epi8(vy, vuv));
+			_mm_storeu_si128(out + 2 * i + 1,
+				_mm_unpackhi_epi8(vy, vuv));
+		}
+		y = (const __m128i *)((const char *)y + width);
+	}
+}
+
+__attribute__((target("avx2")))
+static void conv_nv12_avx2(char *dst, const char *src, int width,
+			   int height)
+{
+	const char *ybase = src;
+	const char *uvbase = src + (size_t)width * height;
+	int vecs = width / 32;
+
+	for (int row = 0; row < height; row++) {
+		const __m256i *y = (const __m256i *)
+			(ybase + (size_t)row * width);
+		const __m256i *uv = (const __m256i *)
+			(uvbase + (size_t)(row / 2) * width);
+		__m256i *out = (__m256i *)(dst +
+			(size_t)row * width * 2);
+		for (int i = 0; i < vecs; i++) {
+			__m256i vy = _mm256_loadu_si256(y + i);
+			__m256i vuv = _mm256_loadu_si256(uv + i);
+			__m256i lo = _mm256_unpacklo_epi8(vy, vuv);
+			__m256i hi = _mm256_unpackhi_epi8(vy, vuv);
+			/* unpack works per 128-bit lane; restore
+			 * byte order across lanes */
+			_mm256_storeu_si256(out + 2 * i,
+				_mm256_permute2x128_si256(lo, hi,
+							  0x20));
+			_mm256_storeu_si256(out + 2 * i + 1,
+				_mm256_permute2x128_si256(lo, hi,
+							  0x31));
+		}
+	}
+}
+
+__attribute__((target("sse2")))
+static void conv_uyvy_sse2(char *dst, const char *src, int width,
+			   int height)
+{
+	size_t n = (size_t)width * height * 2;
+
+	for (size_t i = 0; i < n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)
+					    (src + i));
+		v = _mm_or_si128(_mm_slli_epi16(v, 8),
+				 _mm_srli_epi16(v, 8));
+		_mm_storeu_si128((__m128i *)(dst + i), v);
+	}
+}
+
+__attribute__((target("avx2")))
+static void conv_uyvy_avx2(char *dst, const char *src, int width,
+			   int height)
+{
+	size_t n = (size_t)width * height * 2;
+
+	for (size_t i = 0; i < n; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)
+					       (src + i));
+		v = _mm256_or_si256(_mm256_slli_epi16(v, 8),
+				    _mm256_srli_epi16(v, 8));
+		_mm256_storeu_si256((__m256i *)(dst + i), v);
+	}
+}
+#endif /* x86 */
+
+static struct converter converters[] = {
+	{ "nv12-yuy2", 3, 2, conv_nv12_scalar },
+	{ "uyvy-yuy2", 2, 1, conv_uyvy_scalar },
+};
+
+/* Pick the named converter and bind the best kernel the CPU has.
+ * Vector kernels assume width is a multiple of 32 (true of every
+ * mode we relay); odd widths keep the scalar path. */
+static const struct converter *lookup_converter(const char *name,
+						int width)
+{
+	for (size_t i = 0;
+	     i < sizeof(converters) / sizeof(converters[0]); i++) {
+		if (strcmp(converters[i].name, name) != 0)
+			continue;
+#if defined(__x86_64__) || defined(__i386__)
+		if (width % 32 == 0) {
+			if (__builtin_cpu_supports("avx2"))
+				converters[i].fn = i == 0 ?
+					conv_nv12_avx2 : conv_uyvy_avx2;
+			else if (__builtin_cpu_supports("sse2"))
+				converters[i].fn = i == 0 ?
+					conv_nv12_sse2 : conv_uyvy_sse2;
+		}
+#endif
+		return &converters[i];
+	}
+	return NULL;
+}
+
+/*
+ * Streaming-I/O (MMAP) output path.
+ *
+ * Instead of write()ing each frame (one full userspace→kernel copy),
+ * we request driver-allocated buffers, mmap them, and queue/dequeue
+ * with QBUF/DQBUF. The relay loop reads pipeline data straight into
+ * the mapped buffer, so a relayed frame is copied exactly once (pipe
+ * → mapped buffer) instead of twice (pipe → frame_buf → device).
+ */
+#define OUT_NBUFS 4
+
+enum io_mode {
+	IO_WRITE,	/* classic write() per frame (default) */
+	IO_MMAP,	/* VIDIOC_REQBUFS/QBUF/DQBUF streaming I/O */
+	IO_SPLICE,	/* splice() pipe pages straight to the device */
+	IO_URING,	/* io_uring linked read→write submissions */
+};
+
+struct out_mmap {
+	void *mem[OUT_NBUFS];
+	unsigned int length[OUT_NBUFS];
+	int nbufs;
+	int fresh;	/* buffers never queued yet (claimed in order) */
+	int streaming;
+};
+
+/* Negotiate MMAP buffers on the writer fd. Returns 0 on success,
+ * -1 if the driver lacks output-side streaming I/O. */
+static int out_mmap_setup(int fd, struct out_mmap *om)
+{
+	struct v4l2_requestbuffers req;
+
+	memset(om, 0, sizeof(*om));
+	memset(&req, 0, sizeof(req));
+	req.count = OUT_NBUFS;
+	req.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+	req.memory = V4L2_MEMORY_MMAP;
+
+	if (xioctl(fd, VIDIOC_REQBUFS, &req) < 0 || req.count < 2) {
+		fprintf(stderr,
+			"[monitor] REQBUFS unsupported (%s), falling back"
+			" to write() I/O\n", strerror(errno));
+		return -1;
+	}
+
+	om->nbufs = req.count;
+	for (int i = 0; i < om->nbufs; i++) {
+		struct v4l2_buffer buf;
+		memset(&buf, 0, sizeof(buf));
+		buf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+		buf.memory = V4L2_MEMORY_MMAP;
+		buf.index = i;
+
+		if (xioctl(fd, VIDIOC_QUERYBUF, &buf) < 0) {
+			fprintf(stderr, "[monitor] QUERYBUF(%d): %s\n",
+				i, strerror(errno));
+			return -1;
+		}
+
+		om->length[i] = buf.length;
+		om->mem[i] = mmap(NULL, buf.length,
+				  PROT_READ | PROT_WRITE, MAP_SHARED,
+				  fd, buf.m.offset);
+		if (om->mem[i] == MAP_FAILED) {
+			fprintf(stderr, "[monitor] mmap(%d): %s\n",
+				i, strerror(errno));
+			om->mem[i] = NULL;
+			return -1;
+		}
+	}
+
+	fprintf(stderr, "[monitor] Streaming I/O: %d MMAP buffers of %u"
+		" bytes\n", om->nbufs, om->length[0]);
+	return 0;
+}
+
+static void out_mmap_teardown(int fd, struct out_mmap *om)
+{
+	if (om->streaming) {
+		enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+		xioctl(fd, VIDIOC_STREAMOFF, &type);
+		om->streaming = 0;
+	}
+	for (int i = 0; i < om->nbufs; i++) {
+		if (om->mem[i])
+			munmap(om->mem[i], om->length[i]);
+		om->mem[i] = NULL;
+	}
+	om->nbufs = 0;
+	om->fresh = 0;
+}
+
+/* Claim a buffer to fill: hand out never-queued buffers first, then
+ * block in DQBUF until the driver returns one. Returns the buffer
+ * index, or -1 on error. */
+static int out_mmap_claim(int fd, struct out_mmap *om)
+{
+	if (om->fresh < om->nbufs)
+		return om->fresh++;
+
+	struct v4l2_buffer buf;
+	memset(&buf, 0, sizeof(buf));
+	buf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+	buf.memory = V4L2_MEMORY_MMAP;
+	if (xioctl(fd, VIDIOC_DQBUF, &buf) < 0) {
+		fprintf(stderr, "[monitor] DQBUF: %s\n", strerror(errno));
+		return -1;
+	}
+	return buf.index;
+}
+
+/* Queue a filled buffer; starts streaming on the first submission.
+ * Returns 0 on success, -1 on error. */
+static int out_mmap_submit(int fd, struct out_mmap *om, int index,
+			   int bytes)
+{
+	struct v4l2_buffer buf;
+	memset(&buf, 0, sizeof(buf));
+	buf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+	buf.memory = V4L2_MEMORY_MMAP;
+	buf.index = index;
+	buf.bytesused = bytes;
+
+	if (xioctl(fd, VIDIOC_QBUF, &buf) < 0) {
+		fprintf(stderr, "[monitor] QBUF: %s\n", strerror(errno));
+		return -1;
+	}
+
+	if (!om->streaming) {
+		enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+		if (xioctl(fd, VIDIOC_STREAMON, &type) < 0) {
+			fprintf(stderr, "[monitor] STREAMON: %s\n",
+				strerror(errno));
+			return -1;
+		}
+		om->streaming = 1;
+	}
+	return 0;
+}
+
+/*
+ * Telemetry. Counters live in one global struct so the hot paths
+ * (put_frame, the embed callback, the /proc scanner) can bump them
+ * without threading a pointer everywhere. Device-write latency goes
+ * into power-of-two microsecond buckets — two clock_gettime() calls
+ * per frame, nothing else.
+ *
+ * Every STATS_INTERVAL_SEC a STATS line is emitted on stdout next to
+ * READY/START/STOP, one key=value pair per field, so the systray and
+ * fleet tooling can parse it without a schema.
+ */
+#define STATS_INTERVAL_SEC	10
+#define STATS_LAT_BUCKETS	20	/* 1us .. ~0.5s */
+
+struct relay_stats {
+	unsigned long frames;	/* frames written to the device */
+	unsigned long black;	/* of which synthetic black frames */
+	unsigned long restarts;	/* pipeline restarts within sessions */
+	unsigned long scans;	/* full /proc openers scans */
+	unsigned long long scan_ns;	/* time spent in those scans */
+	unsigned long lat[STATS_LAT_BUCKETS];
+};
+
+static struct relay_stats stats;
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ull +
+	       ts.tv_nsec;
+}
+
+static void stats_lat_record(unsigned long long ns)
+{
+	unsigned long long us = ns / 1000;
+	int b = 0;
+
+	while (us > 1 && b < STATS_LAT_BUCKETS - 1) {
+		us >>= 1;
+		b++;
+	}
+	stats.lat[b]++;
+}
+
+/* Upper bound (us) of the bucket holding the pct-th percentile. */
+static unsigned long stats_lat_pct(int pct)
+{
+	unsigned long total = 0, seen = 0;
+
+	for (int i = 0; i < STATS_LAT_BUCKETS; i++)
+		total += stats.lat[i];
+	if (total == 0)
+		return 0;
+	unsigned long target = (total * pct + 99) / 100;
+	for (int i = 0; i < STATS_LAT_BUCKETS; i++) {
+		seen += stats.lat[i];
+		if (seen >= target)
+			return 1ul << i;
+	}
+	return 1ul << (STATS_LAT_BUCKETS - 1);
+}
+
+static void stats_emit(long drops, int clients)
+{
+	printf("STATS frames=%lu black=%lu drops=%ld restarts=%lu"
+	       " clients=%d scan_us_avg=%llu wlat_us_p50=%lu"
+	       " wlat_us_p99=%lu\n",
+	       stats.frames, stats.black, drops, stats.restarts,
+	       clients,
+	       stats.scans ? stats.scan_ns / stats.scans / 1000 : 0,
+	       stats_lat_pct(50), stats_lat_pct(99));
+	fflush(stdout);
+}
+
+/*
+ * Event socket. Push counterpart to the stdout line protocol: a unix
+ * SOCK_SEQPACKET listener at $XDG_RUNTIME_DIR/camera-relay-events
+ * (falling back to /tmp) delivers one fixed-size struct relay_event
+ * per READY/START/STOP/RESTART/STATS event to every connected
+ * subscriber. SEQPACKET gives message framing for free — a subscriber
+ * recv()s exactly one event per call, no delimiter scanning — and the
+ * version field up front lets the layout grow without breaking old
+ * readers. Sends are non-blocking: a subscriber that stops reading
+ * loses packets, never stalls the relay; a subscriber that vanishes
+ * is dropped on the next send error.
+ */
+#define EVSOCK_NAME		"camera-relay-events"
+#define EVSOCK_MAX_SUBS		8
+#define RELAY_EVENT_VERSION	1
+
+enum relay_event_type {
+	RELAY_EV_READY = 0,
+	RELAY_EV_START = 1,
+	RELAY_EV_STOP = 2,
+	RELAY_EV_RESTART = 3,
+	RELAY_EV_STATS = 4,
+};
+
+/* Wire format: 64 bytes, little-endian (native — both ends are this
+ * machine), no padding. Grow only by appending fields and bumping
+ * RELAY_EVENT_VERSION. */
+struct relay_event {
+	uint16_t version;	/* RELAY_EVENT_VERSION */
+	uint16_t type;		/* enum relay_event_type */
+	uint32_t clients;	/* capture clients at emit time */
+	uint64_t t_mono_ns;	/* CLOCK_MONOTONIC timestamp */
+	uint64_t frames;	/* cumulative device writes */
+	uint64_t black;		/* of which synthetic black */
+	uint64_t drops;		/* late frames dropped (--drop) */
+	uint64_t restarts;	/* pipeline restarts */
+	uint32_t fps_centi;	/* frames/s since prior event, x100 */
+	uint32_t wlat_us_p50;	/* device-write latency percentiles */
+	uint32_t wlat_us_p99;
+	uint32_t restart_delay_ms;	/* RESTART only: backoff delay */
+} __attribute__((packed));
+
+_Static_assert(sizeof(struct relay_event) == 64,
+	       "relay_event wire format must stay 64 bytes");
+
+static int evsock_fd = -1;
+static int evsock_subs[EVSOCK_MAX_SUBS];
+static int evsock_n_subs;
+static char evsock_path[96];
+static struct relay_event evsock_last;	/* snapshot for new subscribers */
+
+static void evsock_init(void)
+{
+	const char *dir = getenv("XDG_RUNTIME_DIR");
+	struct sockaddr_un addr;
+
+	snprintf(evsock_path, sizeof(evsock_path), "%s/" EVSOCK_NAME,
+		 dir && *dir ? dir : "/tmp");
+
+	evsock_fd = socket(AF_UNIX,
+			   SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (evsock_fd < 0)
+		goto fail;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", evsock_path);
+	unlink(evsock_path);	/* stale socket from a previous run */
+	if (bind(evsock_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    listen(evsock_fd, 4) < 0) {
+		close(evsock_fd);
+		evsock_fd = -1;
+		goto fail;
+	}
+	fprintf(stderr, "[monitor] Event socket at %s\n", evsock_path);
+	return;
+fail:
+	fprintf(stderr,
+		"[monitor] Event socket unavailable (%s) — stdout only\n",
+		strerror(errno));
+}
+
+static void evsock_emit(uint16_t type, int clients, long drops,
+			int delay_ms)
+{
+	static unsigned long long last_ns;
+	static unsigned long last_frames;
+	struct relay_event ev;
+	unsigned long long now = now_ns();
+	int i = 0;
+
+	if (evsock_fd < 0)
+		return;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.version = RELAY_EVENT_VERSION;
+	ev.type = type;
+	ev.clients = clients > 0 ? (uint32_t)clients : 0;
+	ev.t_mono_ns = now;
+	ev.frames = stats.frames;
+	ev.black = stats.black;
+	ev.drops = drops > 0 ? (uint64_t)drops : 0;
+	ev.restarts = stats.restarts;
+	if (last_ns && now > last_ns && stats.frames >= last_frames)
+		ev.fps_centi = (uint32_t)((stats.frames - last_frames) *
+					  100000000000ull / (now - last_ns));
+	ev.wlat_us_p50 = (uint32_t)stats_lat_pct(50);
+	ev.wlat_us_p99 = (uint32_t)stats_lat_pct(99);
+	ev.restart_delay_ms = (uint32_t)delay_ms;
+	last_ns = now;
+	last_frames = stats.frames;
+	evsock_last = ev;
+
+	while (i < evsock_n_subs) {
+		if (send(evsock_subs[i], &ev, sizeof(ev),
+			 MSG_DONTWAIT | MSG_NOSIGNAL) < 0 &&
+		    errno != EAGAIN && errno != EWOULDBLOCK) {
+			/* Subscriber gone — drop it, keep the rest. */
+			close(evsock_subs[i]);
+			evsock_subs[i] = evsock_subs[--evsock_n_subs];
+			continue;
+		}
+		i++;	/* EAGAIN loses this packet, keeps the sub */
+	}
+}
+
+static void evsock_accept(void)
+{
+	for (;;) {
+		int c = accept4(evsock_fd, NULL, NULL,
+				SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (c < 0)
+			return;
+		if (evsock_n_subs >= EVSOCK_MAX_SUBS) {
+			close(c);
+			continue;
+		}
+		/* Sync the newcomer immediately instead of making it
+		 * wait up to STATS_INTERVAL_SEC for the next event. */
+		send(c, &evsock_last, sizeof(evsock_last),
+		     MSG_DONTWAIT | MSG_NOSIGNAL);
+		evsock_subs[evsock_n_subs++] = c;
+	}
+}
+
+static void evsock_cleanup(void)
+{
+	for (int i = 0; i < evsock_n_subs; i++)
+		close(evsock_subs[i]);
+	evsock_n_subs = 0;
+	if (evsock_fd >= 0) {
+		close(evsock_fd);
+		unlink(evsock_path);
+		evsock_fd = -1;
+	}
+}
+
+/*
+ * Fan-out mirrors (--mirror=DEV, repeatable). One capture pipeline
+ * feeds N loopback devices, so a second consumer (OBS next to a
+ * browser call) never forces a second libcamera/ISP stream — the
+ * exact -EBUSY case cheese-camerabin-fix.c works around. Mirrors
+ * always take plain write() I/O; a mirror that fails is dropped with
+ * a log rather than taking the session down.
+ */
+#define MAX_MIRRORS 4
+
+static struct {
+	const char *path;
+	int fd;
+} mirrors[MAX_MIRRORS];
+static int n_mirrors;
+
+static void mirror_put(const char *data, int len)
+{
+	for (int i = 0; i < n_mirrors; i++) {
+		if (mirrors[i].fd < 0)
+			continue;
+		if (write(mirrors[i].fd, data, len) != len) {
+			fprintf(stderr,
+				"[monitor] Mirror %s write: %s"
+				" — dropping mirror\n",
+				mirrors[i].path, strerror(errno));
+			close(mirrors[i].fd);
+			mirrors[i].fd = -1;
+		}
+	}
+}
+
+/* Write one frame from a userspace buffer to the device, via either
+ * I/O path. Used for black frames and the write()-mode relay. */
+static int put_frame(int fd, enum io_mode mode, struct out_mmap *om,
+		     const char *data, int frame_size)
+{
+	unsigned long long t0 = now_ns();
+	int ret;
+
+	if (mode == IO_MMAP) {
+		int idx = out_mmap_claim(fd, om);
+		if (idx < 0)
+			return -1;
+		memcpy(om->mem[idx], data, frame_size);
+		ret = out_mmap_submit(fd, om, idx, frame_size);
+	} else {
+		ret = write(fd, data, frame_size) == frame_size ?
+			0 : -1;
+	}
+	if (ret == 0) {
+		mirror_put(data, frame_size);
+		stats.frames++;
+		stats_lat_record(now_ns() - t0);
+	}
+	return ret;
+}
+
+#ifdef HAVE_IO_URING
+/*
+ * io_uring relay engine (--io=uring, pipe transport only).
+ *
+ * The write()-mode relay costs at least two blocking syscalls per
+ * frame (pipe read — often several, on short reads — plus the device
+ * write) and cannot overlap reading frame N+1 with writing frame N.
+ * Here both operations ride one ring: each frame is a linked
+ * READ_FIXED(pipe) → WRITE_FIXED(device) pair on a registered buffer,
+ * so the kernel starts the device write the moment the read lands,
+ * with no wakeup in between. A multishot POLL_ADD on the pipe replaces
+ * per-iteration readiness syscalls; all completions surface through
+ * one registered eventfd in the main epoll set.
+ *
+ * Submission is gated on FIONREAD covering the whole frame (the same
+ * trick as the splice path), so reads never come up short in normal
+ * operation and the in-flight frame count stays exact. Two registered
+ * buffers keep one frame reading while the previous one writes; with
+ * both in flight, adjacent completions can in theory reorder at the
+ * device, which for full-frame v4l2loopback writes is at worst a
+ * one-frame visual swap while already running behind.
+ *
+ * The ring is created per pipeline session and torn down with it. A
+ * kernel without io_uring (or a device that rejects uring writes)
+ * falls back to write() I/O exactly like the splice path does.
+ */
+#define URING_ENTRIES	8
+#define URING_NBUFS	2
+
+/* user_data tags; low byte carries the buffer index */
+#define URING_UD_POLL	0x100
+#define URING_UD_READ	0x200
+#define URING_UD_WRITE	0x300
+
+struct uring {
+	int fd;			/* ring fd, -1 when inactive */
+	int event_fd;		/* registered completion eventfd */
+	unsigned *sq_tail, *sq_mask, *sq_array;
+	unsigned *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *ring_mem;
+	size_t ring_sz, sqes_sz;
+	unsigned tail;		/* local tail, published on submit */
+	char *bufs[URING_NBUFS];
+	int buf_busy[URING_NBUFS];
+	unsigned long long buf_t0[URING_NBUFS];
+	int inflight;		/* chains submitted, write not done */
+	int pending_reads;	/* reads submitted, CQE not reaped */
+};
+
+static int uring_setup_sys(unsigned entries, struct io_uring_params *p)
+{
+	return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uring_enter_sys(int fd, unsigned to_submit)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, 0, 0, NULL, 0);
+}
+
+static int uring_register_sys(int fd, unsigned op, void *arg, unsigned nr)
+{
+	return syscall(__NR_io_uring_register, fd, op, arg, nr);
+}
+
+static void uring_stop(struct uring *u)
+{
+	if (u->fd < 0)
+		return;
+	close(u->fd);
+	u->fd = -1;
+	if (u->event_fd >= 0)
+		close(u->event_fd);
+	u->event_fd = -1;
+	if (u->sqes)
+		munmap(u->sqes, u->sqes_sz);
+	if (u->ring_mem)
+		munmap(u->ring_mem, u->ring_sz);
+	u->sqes = NULL;
+	u->ring_mem = NULL;
+	for (int i = 0; i < URING_NBUFS; i++) {
+		free(u->bufs[i]);
+		u->bufs[i] = NULL;
+		u->buf_busy[i] = 0;
+	}
+	u->inflight = 0;
+	u->pending_reads = 0;
+}
+
+/* Next SQE slot. Caps above guarantee at most 1 poll + URING_NBUFS
+ * linked pairs outstanding, well under URING_ENTRIES. */
+static struct io_uring_sqe *uring_sqe(struct uring *u)
+{
+	unsigned idx = u->tail & *u->sq_mask;
+	struct io_uring_sqe *sqe = &u->sqes[idx];
+
+	memset(sqe, 0, sizeof(*sqe));
+	u->sq_array[idx] = idx;
+	u->tail++;
+	return sqe;
+}
+
+static int uring_submit(struct uring *u, unsigned n)
+{
+	int r;
+
+	__atomic_store_n(u->sq_tail, u->tail, __ATOMIC_RELEASE);
+	do {
+		r = uring_enter_sys(u->fd, n);
+	} while (r < 0 && errno == EINTR);
+	return r;
+}
+
+/* Arm (or re-arm) the multishot pipe-readability poll. */
+static void uring_arm_poll(struct uring *u, int pipe_fd)
+{
+	struct io_uring_sqe *sqe = uring_sqe(u);
+
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = pipe_fd;
+	sqe->len = IORING_POLL_ADD_MULTI;
+	sqe->poll32_events = POLLIN | POLLRDHUP;
+	sqe->user_data = URING_UD_POLL;
+	uring_submit(u, 1);
+}
+
+/* Queue one frame: linked read(pipe → buf) → write(buf → device). */
+static void uring_queue_frame(struct uring *u, int pipe_fd, int dev_fd,
+			      int frame_size, int buf)
+{
+	struct io_uring_sqe *sqe = uring_sqe(u);
+
+	sqe->opcode = IORING_OP_READ_FIXED;
+	sqe->fd = pipe_fd;
+	sqe->addr = (uint64_t)(uintptr_t)u->bufs[buf];
+	sqe->len = frame_size;
+	sqe->off = (uint64_t)-1;
+	sqe->buf_index = buf;
+	sqe->flags = IOSQE_IO_LINK;
+	sqe->user_data = URING_UD_READ | buf;
+
+	sqe = uring_sqe(u);
+	sqe->opcode = IORING_OP_WRITE_FIXED;
+	sqe->fd = dev_fd;
+	sqe->addr = (uint64_t)(uintptr_t)u->bufs[buf];
+	sqe->len = frame_size;
+	sqe->off = (uint64_t)-1;
+	sqe->buf_index = buf;
+	sqe->user_data = URING_UD_WRITE | buf;
+
+	u->buf_busy[buf] = 1;
+	u->buf_t0[buf] = now_ns();
+	u->inflight++;
+	u->pending_reads++;
+	uring_submit(u, 2);
+}
+
+/* Create the per-session ring: registered frame buffers, completion
+ * eventfd, multishot pipe poll. Returns 0, or -1 (cleaned up) when
+ * the kernel or allocation lets us down — caller falls back to
+ * write() I/O. */
+static int uring_start(struct uring *u, int pipe_fd, int frame_size)
+{
+	struct io_uring_params p;
+	struct iovec iov[URING_NBUFS];
+
+	memset(u, 0, sizeof(*u));
+	u->fd = -1;
+	u->event_fd = -1;
+
+	memset(&p, 0, sizeof(p));
+	u->fd = uring_setup_sys(URING_ENTRIES, &p);
+	if (u->fd < 0) {
+		fprintf(stderr, "[monitor] io_uring_setup: %s\n",
+			strerror(errno));
+		return -1;
+	}
+	if (!(p.features & IORING_FEAT_SINGLE_MMAP))
+		goto fail;
+
+	u->ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	size_t cq_sz = p.cq_off.cqes +
+		p.cq_entries * sizeof(struct io_uring_cqe);
+	if (cq_sz > u->ring_sz)
+		u->ring_sz = cq_sz;
+	u->ring_mem = mmap(NULL, u->ring_sz, PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_POPULATE, u->fd,
+			   IORING_OFF_SQ_RING);
+	if (u->ring_mem == MAP_FAILED) {
+		u->ring_mem = NULL;
+		goto fail;
+	}
+	u->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+	u->sqes = mmap(NULL, u->sqes_sz, PROT_READ | PROT_WRITE,
+		       MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+	if (u->sqes == MAP_FAILED) {
+		u->sqes = NULL;
+		goto fail;
+	}
+
+	char *r = u->ring_mem;
+	u->sq_tail = (unsigned *)(r + p.sq_off.tail);
+	u->sq_mask = (unsigned *)(r + p.sq_off.ring_mask);
+	u->sq_array = (unsigned *)(r + p.sq_off.array);
+	u->cq_head = (unsigned *)(r + p.cq_off.head);
+	u->cq_tail = (unsigned *)(r + p.cq_off.tail);
+	u->cq_mask = (unsigned *)(r + p.cq_off.ring_mask);
+	u->cqes = (struct io_uring_cqe *)(r + p.cq_off.cqes);
+	u->tail = *u->sq_tail;
+
+	for (int i = 0; i < URING_NBUFS; i++) {
+		u->bufs[i] = malloc(frame_size);
+		if (!u->bufs[i])
+			goto fail;
+		iov[i].iov_base = u->bufs[i];
+		iov[i].iov_len = frame_size;
+	}
+	if (uring_register_sys(u->fd, IORING_REGISTER_BUFFERS, iov,
+			       URING_NBUFS) < 0)
+		goto fail;
+
+	u->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (u->event_fd < 0 ||
+	    uring_register_sys(u->fd, IORING_REGISTER_EVENTFD,
+			       &u->event_fd, 1) < 0)
+		goto fail;
+
+	uring_arm_poll(u, pipe_fd);
+	fprintf(stderr, "[monitor] io_uring relay: %u entries, %d"
+		" registered buffers of %d bytes\n",
+		p.sq_entries, URING_NBUFS, frame_size);
+	return 0;
+fail:
+	fprintf(stderr, "[monitor] io_uring setup incomplete: %s\n",
+		strerror(errno));
+	uring_stop(u);
+	return -1;
+}
+#endif /* HAVE_IO_URING */
+
 /* Count processes (other than ours and our children) that have this
  * device open. Skips our PID and the pipeline child PID.
  *
@@ -67,8 +1043,8 @@ static int xioctl(int fd, unsigned long request, void *arg)
  * (symlink, /dev/v4l/by-id, etc.). UID filtering skips system
  * processes for efficiency.
  */
-static int count_other_openers(dev_t dev_id, pid_t our_pid,
-			       pid_t child_pid)
+static int count_other_openers(const dev_t *dev_ids, int ndev,
+			       pid_t our_pid, pid_t child_pid)
 {
 	DIR *proc_dir;
 	struct dirent *proc_entry;
@@ -124,12 +1100,17 @@ static int count_other_openers(dev_t dev_id, pid_t our_pid,
 			snprintf(link_path, sizeof(link_path),
 				 "%s/%s", fd_dir_path, fd_entry->d_name);
 
-			if (stat(link_path, &st) == 0 &&
-			    S_ISCHR(st.st_mode) &&
-			    st.st_rdev == dev_id) {
-				found = 1;
-				break;
+			if (stat(link_path, &st) != 0 ||
+			    !S_ISCHR(st.st_mode))
+				continue;
+			for (int d = 0; d < ndev; d++) {
+				if (st.st_rdev == dev_ids[d]) {
+					found = 1;
+					break;
+				}
 			}
+			if (found)
+				break;
 		}
 		closedir(fd_dir);
 		if (found)
@@ -139,10 +1120,215 @@ static int count_other_openers(dev_t dev_id, pid_t our_pid,
 	return count;
 }
 
-/* Open device for writing, set format, write initial black frame.
+/*
+ * Shared-memory SPSC ring transport (--transport=shm).
+ *
+ * A memfd-backed ring of whole-frame slots shared with the pipeline
+ * subprocess: the producer writes a frame into slot head%slots, sets
+ * used[slot], bumps head, and signals the eventfd; the monitor maps
+ * the same memory and consumes slots at tail. No pipe syscalls per
+ * frame, no 8MB kernel pipe, and a frame is never split across
+ * partial reads — this is the transport that scales to 4K frames
+ * which exceed any sane pipe size.
+ *
+ * Child-side contract: fd 3 is the memfd (mmap it), fd 4 is the
+ * eventfd (write 1 after bumping head), and CAMERA_RELAY_SHM in the
+ * environment carries "slots=N slot_size=M". A ring-aware producer
+ * is required — plain fdsink will not work, so the default transport
+ * remains the pipe. The eventfd stands in for raw futex wakeups: it
+ * is the pollable equivalent and folds into the epoll loop.
+ */
+#define SHM_RING_SLOTS 4
+#define SHM_RING_MAGIC 0x31525243u	/* "CRR1" */
+
+struct shm_ring_hdr {
+	uint32_t magic;
+	uint32_t slots;
+	uint32_t slot_size;
+	uint32_t used[SHM_RING_SLOTS];	/* bytes valid in each slot */
+	volatile uint32_t head;		/* producer: next slot to fill */
+	volatile uint32_t tail;		/* consumer: next slot to read */
+};
+
+struct shm_ring {
+	struct shm_ring_hdr *hdr;
+	char *slots;			/* slot data follows the header */
+	size_t map_len;
+	int mem_fd;
+	int event_fd;
+};
+
+static int shm_ring_create(struct shm_ring *r, int slot_size)
+{
+	memset(r, 0, sizeof(*r));
+	r->mem_fd = -1;
+	r->event_fd = -1;
+	r->map_len = sizeof(struct shm_ring_hdr) +
+		     (size_t)SHM_RING_SLOTS * slot_size;
+
+	r->mem_fd = memfd_create("camera-relay-ring", 0);
+	if (r->mem_fd < 0 ||
+	    ftruncate(r->mem_fd, r->map_len) < 0) {
+		fprintf(stderr, "[monitor] shm ring memfd: %s\n",
+			strerror(errno));
+		goto fail;
+	}
+
+	r->hdr = mmap(NULL, r->map_len, PROT_READ | PROT_WRITE,
+		      MAP_SHARED, r->mem_fd, 0);
+	if (r->hdr == MAP_FAILED) {
+		r->hdr = NULL;
+		fprintf(stderr, "[monitor] shm ring mmap: %s\n",
+			strerror(errno));
+		goto fail;
+	}
+	r->slots = (char *)(r->hdr + 1);
+
+	r->event_fd = eventfd(0, EFD_NONBLOCK);
+	if (r->event_fd < 0) {
+		fprintf(stderr, "[monitor] shm ring eventfd: %s\n",
+			strerror(errno));
+		goto fail;
+	}
+
+	r->hdr->magic = SHM_RING_MAGIC;
+	r->hdr->slots = SHM_RING_SLOTS;
+	r->hdr->slot_size = slot_size;
+	return 0;
+
+fail:
+	if (r->hdr)
+		munmap(r->hdr, r->map_len);
+	if (r->mem_fd >= 0)
+		close(r->mem_fd);
+	if (r->event_fd >= 0)
+		close(r->event_fd);
+	memset(r, 0, sizeof(*r));
+	r->mem_fd = -1;
+	r->event_fd = -1;
+	return -1;
+}
+
+static void shm_ring_destroy(struct shm_ring *r)
+{
+	if (r->hdr)
+		munmap(r->hdr, r->map_len);
+	if (r->mem_fd >= 0)
+		close(r->mem_fd);
+	if (r->event_fd >= 0)
+		close(r->event_fd);
+	r->hdr = NULL;
+	r->mem_fd = -1;
+	r->event_fd = -1;
+}
+
+/* Reset indices for a new pipeline session. */
+static void shm_ring_reset(struct shm_ring *r)
+{
+	if (!r->hdr)
+		return;
+	memset(r->hdr->used, 0, sizeof(r->hdr->used));
+	r->hdr->head = 0;
+	r->hdr->tail = 0;
+	uint64_t cnt;
+	(void)!read(r->event_fd, &cnt, sizeof(cnt));
+}
+
+/*
+ * Event-driven client tracking.
+ *
+ * The /proc-wide scan in count_other_openers() is the authoritative
+ * count, but it stats every same-UID process and every fd symlink —
+ * milliseconds of syscalls on busy machines. The tracker watches the
+ * device node with inotify (IN_OPEN/IN_CLOSE), so the scan only runs
+ * when something actually opened or closed the device, plus a
+ * low-frequency consistency check in case an event was lost.
+ * Together with the v4l2loopback event API this makes detection
+ * event-driven instead of scan-per-poll-cycle.
+ */
+#define TRACKER_CONSISTENCY_SEC 30
+
+struct tracker {
+	int ino_fd;		/* inotify instance, -1 if unavailable */
+	int clients;		/* last authoritative count */
+	time_t last_scan;	/* when the /proc scan last ran */
+};
+
+static int tracker_init(struct tracker *t, const char *device)
+{
+	memset(t, 0, sizeof(*t));
+	t->ino_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (t->ino_fd < 0)
+		return -1;
+	if (inotify_add_watch(t->ino_fd, device,
+			      IN_OPEN | IN_CLOSE) < 0) {
+		close(t->ino_fd);
+		t->ino_fd = -1;
+		return -1;
+	}
+	return 0;
+}
+
+static void tracker_close(struct tracker *t)
+{
+	if (t->ino_fd >= 0)
+		close(t->ino_fd);
+	t->ino_fd = -1;
+}
+
+/* Drain pending inotify events. Returns 1 if any open/close activity
+ * was seen (so a /proc rescan is warranted), 0 otherwise. */
+static int tracker_drain(struct tracker *t)
+{
+	char buf[4096] __attribute__((aligned(__alignof__(
+					struct inotify_event))));
+	int activity = 0;
+
+	if (t->ino_fd < 0)
+		return 0;
+	for (;;) {
+		ssize_t len = read(t->ino_fd, buf, sizeof(buf));
+		if (len <= 0)
+			break;
+		activity = 1;
+	}
+	return activity;
+}
+
+/* Authoritative recount via /proc, remembering when it ran. */
+static int tracker_scan(struct tracker *t, const dev_t *dev_ids,
+			int ndev, pid_t our_pid, pid_t child_pid)
+{
+	unsigned long long t0 = now_ns();
+
+	t->clients = count_other_openers(dev_ids, ndev, our_pid,
+					 child_pid);
+	t->last_scan = time(NULL);
+	stats.scans++;
+	stats.scan_ns += now_ns() - t0;
+	return t->clients;
+}
+
+/* Refresh the count if the device saw open/close activity or the
+ * consistency interval elapsed; otherwise return the cached count
+ * without touching /proc. */
+static int tracker_refresh(struct tracker *t, const dev_t *dev_ids,
+			   int ndev, pid_t our_pid, pid_t child_pid)
+{
+	if (tracker_drain(t) ||
+	    time(NULL) - t->last_scan >= TRACKER_CONSISTENCY_SEC ||
+	    t->ino_fd < 0)
+		return tracker_scan(t, dev_ids, ndev, our_pid,
+				    child_pid);
+	return t->clients;
+}
+
+/* Open device for writing and set format. The caller writes the
+ * initial black frame through put_frame() once the I/O path is set
+ * up (write() before REQBUFS would pin the driver to file I/O).
  * Returns fd on success, -1 on failure. */
 static int open_writer(const char *device, int width, int height,
-		       int frame_size, const char *black_frame)
+		       uint32_t fourcc, int frame_size)
 {
 	int fd = open(device, O_WRONLY);
 	if (fd < 0) {
@@ -156,7 +1342,7 @@ static int open_writer(const char *device, int width, int height,
 	fmt.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
 	fmt.fmt.pix.width = width;
 	fmt.fmt.pix.height = height;
-	fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
+	fmt.fmt.pix.pixelformat = fourcc;
 	fmt.fmt.pix.sizeimage = frame_size;
 	fmt.fmt.pix.field = V4L2_FIELD_NONE;
 
@@ -164,10 +1350,6 @@ static int open_writer(const char *device, int width, int height,
 		fprintf(stderr, "[monitor] S_FMT warning: %s\n",
 			strerror(errno));
 
-	if (write(fd, black_frame, frame_size) != frame_size)
-		fprintf(stderr, "[monitor] Initial write warning: %s\n",
-			strerror(errno));
-
 	return fd;
 }
 
@@ -198,25 +1380,195 @@ static __u32 try_subscribe_events(int fd)
 	return 0;
 }
 
-/* Read exactly n bytes from fd. Returns n on success, <n on EOF/error. */
-static int read_full(int fd, char *buf, int n)
+/* Where the embedded pipeline's streaming thread delivers frames.
+ * Written by the main thread before the pipeline starts (and while
+ * it is stopped), read by the appsink callback. */
+struct frame_out {
+	int fd;
+	enum io_mode io;
+	struct out_mmap *omap;
+	int frame_size;
+};
+
+/*
+ * Embedded pipeline (--embed, requires -DHAVE_GST).
+ *
+ * Builds the GStreamer pipeline in-process with gst_parse_launch and
+ * pulls frames from an appsink named "relaysink" — no fork/exec, no
+ * dynamic-link of the GStreamer stack per client connect, no 8MB
+ * kernel pipe. Client-attach latency drops to pipeline preroll time.
+ *
+ * The pipeline description is the command after "--" joined with
+ * spaces (a leading "gst-launch-1.0" and "-e" are skipped, so the
+ * same wrapper command line works for both modes), and must end in
+ * an appsink named "relaysink" instead of fdsink.
+ */
+#ifdef HAVE_GST
+
+static GstElement *embed_pipeline;
+static GstAppSink *embed_sink;
+static struct frame_out embed_out;
+
+static void embed_set_output(int fd, enum io_mode io,
+			     struct out_mmap *omap, int frame_size)
+{
+	embed_out.fd = fd;
+	embed_out.io = io;
+	embed_out.omap = omap;
+	embed_out.frame_size = frame_size;
+}
+
+/* appsink callback — runs on the GStreamer streaming thread and
+ * writes the frame straight to the device, so frames never touch the
+ * main loop at all in embed mode. */
+static GstFlowReturn embed_on_sample(GstAppSink *sink, gpointer data)
 {
-	int total = 0;
-	while (total < n) {
-		int r = read(fd, buf + total, n - total);
-		if (r <= 0) {
-			if (r == -1 && errno == EINTR)
-				continue;
-			return total;  /* EOF or error */
+	(void)data;
+	GstSample *sample = gst_app_sink_pull_sample(sink);
+	if (!sample)
+		return GST_FLOW_OK;
+
+	GstBuffer *buf = gst_sample_get_buffer(sample);
+	GstMapInfo map;
+	if (buf && gst_buffer_map(buf, &map, GST_MAP_READ)) {
+		if ((int)map.size >= embed_out.frame_size) {
+			put_frame(embed_out.fd, embed_out.io,
+				  embed_out.omap,
+				  (const char *)map.data,
+				  embed_out.frame_size);
 		}
-		total += r;
+		gst_buffer_unmap(buf, &map);
 	}
-	return total;
+	gst_sample_unref(sample);
+	return GST_FLOW_OK;
+}
+
+/* Join the pipeline argv into a parse_launch description. */
+static char *embed_build_desc(char **cmd)
+{
+	size_t len = 1;
+	int first = 0;
+
+	if (cmd[first] && strstr(cmd[first], "gst-launch"))
+		first++;
+	while (cmd[first] && strcmp(cmd[first], "-e") == 0)
+		first++;
+
+	for (int i = first; cmd[i]; i++)
+		len += strlen(cmd[i]) + 1;
+
+	char *desc = malloc(len);
+	if (!desc)
+		return NULL;
+	desc[0] = '\0';
+	for (int i = first; cmd[i]; i++) {
+		strcat(desc, cmd[i]);
+		if (cmd[i + 1])
+			strcat(desc, " ");
+	}
+	return desc;
+}
+
+/* Parse and start the in-process pipeline. Returns 0 on success. */
+static int embed_start(char **cmd)
+{
+	GError *err = NULL;
+
+	if (!gst_is_initialized())
+		gst_init(NULL, NULL);
+
+	char *desc = embed_build_desc(cmd);
+	if (!desc)
+		return -1;
+	fprintf(stderr, "[monitor] Embedded pipeline: %s\n", desc);
+
+	embed_pipeline = gst_parse_launch(desc, &err);
+	free(desc);
+	if (!embed_pipeline) {
+		fprintf(stderr, "[monitor] gst_parse_launch: %s\n",
+			err ? err->message : "unknown error");
+		if (err)
+			g_error_free(err);
+		return -1;
+	}
+	if (err)
+		g_error_free(err);  /* recoverable parse warning */
+
+	GstElement *sink = gst_bin_get_by_name(GST_BIN(embed_pipeline),
+					       "relaysink");
+	if (!sink || !GST_IS_APP_SINK(sink)) {
+		fprintf(stderr, "[monitor] Embedded pipeline needs an"
+			" appsink named \"relaysink\"\n");
+		if (sink)
+			gst_object_unref(sink);
+		gst_object_unref(embed_pipeline);
+		embed_pipeline = NULL;
+		return -1;
+	}
+	embed_sink = GST_APP_SINK(sink);
+	gst_app_sink_set_max_buffers(embed_sink, 3);
+	gst_app_sink_set_drop(embed_sink, TRUE);
+
+	GstAppSinkCallbacks cbs;
+	memset(&cbs, 0, sizeof(cbs));
+	cbs.new_sample = embed_on_sample;
+	gst_app_sink_set_callbacks(embed_sink, &cbs, NULL, NULL);
+
+	if (gst_element_set_state(embed_pipeline, GST_STATE_PLAYING) ==
+	    GST_STATE_CHANGE_FAILURE) {
+		fprintf(stderr, "[monitor] Embedded pipeline refused to"
+			" play\n");
+		gst_object_unref(embed_sink);
+		gst_object_unref(embed_pipeline);
+		embed_sink = NULL;
+		embed_pipeline = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+static void embed_stop(void)
+{
+	if (!embed_pipeline)
+		return;
+	gst_element_set_state(embed_pipeline, GST_STATE_NULL);
+	gst_object_unref(embed_sink);
+	gst_object_unref(embed_pipeline);
+	embed_sink = NULL;
+	embed_pipeline = NULL;
+}
+
+#else  /* !HAVE_GST */
+
+static int embed_start(char **cmd)
+{
+	(void)cmd;
+	fprintf(stderr, "[monitor] Built without -DHAVE_GST, --embed"
+		" unavailable\n");
+	return -1;
+}
+
+static void embed_set_output(int fd, enum io_mode io,
+			     struct out_mmap *omap, int frame_size)
+{
+	(void)fd;
+	(void)io;
+	(void)omap;
+	(void)frame_size;
+}
+
+static void embed_stop(void)
+{
 }
 
-/* Start pipeline subprocess. Stdout goes to a pipe.
- * Returns pipe read fd on success, -1 on failure. Sets *child_pid. */
-static int start_pipeline(char **cmd, pid_t *child_pid)
+#endif  /* HAVE_GST */
+
+/* Start pipeline subprocess. With a ring, fd 3 is the shared memfd
+ * and fd 4 the wakeup eventfd; otherwise stdout-of-fdsink style:
+ * frames flow through a pipe whose read end is returned in *pipe_fd.
+ * Returns 0 on success, -1 on failure. Sets *child_pid. */
+static int start_pipeline(char **cmd, pid_t *child_pid,
+			  struct shm_ring *ring, int *pipe_fd)
 {
 	/* Log the pipeline command for debugging */
 	fprintf(stderr, "[monitor] Pipeline:");
@@ -224,36 +1576,53 @@ static int start_pipeline(char **cmd, pid_t *child_pid)
 		fprintf(stderr, " %s", cmd[i]);
 	fprintf(stderr, "\n");
 
-	int pipefd[2];
-	if (pipe(pipefd) < 0) {
-		fprintf(stderr, "[monitor] pipe() failed: %s\n",
-			strerror(errno));
-		return -1;
-	}
+	int pipefd[2] = { -1, -1 };
+	*pipe_fd = -1;
 
-	/* Pipe buffer must be >= frame size to avoid stalls.
-	 * YUY2 1920x1080 = ~4MB per frame. With a 1MB pipe,
-	 * each frame needs multiple fill/drain cycles causing lag.
-	 * Request 8MB (2 frames) so a full frame can be written
-	 * without blocking on the reader. */
-	fcntl(pipefd[0], F_SETPIPE_SZ, 8388608);
+	if (!ring) {
+		if (pipe(pipefd) < 0) {
+			fprintf(stderr, "[monitor] pipe() failed: %s\n",
+				strerror(errno));
+			return -1;
+		}
+
+		/* Pipe buffer must be >= frame size to avoid stalls.
+		 * YUY2 1920x1080 = ~4MB per frame. With a 1MB pipe,
+		 * each frame needs multiple fill/drain cycles causing
+		 * lag. Request 8MB (2 frames) so a full frame can be
+		 * written without blocking on the reader. */
+		fcntl(pipefd[0], F_SETPIPE_SZ, 8388608);
+	}
 
 	pid_t pid = fork();
 	if (pid < 0) {
 		fprintf(stderr, "[monitor] fork() failed: %s\n",
 			strerror(errno));
-		close(pipefd[0]);
-		close(pipefd[1]);
+		if (!ring) {
+			close(pipefd[0]);
+			close(pipefd[1]);
+		}
 		return -1;
 	}
 
 	if (pid == 0) {
-		/* Child: pipe write end → fd 3 for fdsink.
-		 * Redirect stdout to /dev/null so gst-launch's
+		/* Child: frame sink → fd 3 (pipe write end or ring
+		 * memfd). Redirect stdout to /dev/null so gst-launch's
 		 * status messages don't corrupt the frame stream. */
-		close(pipefd[0]);
-		dup2(pipefd[1], 3);
-		close(pipefd[1]);
+		if (ring) {
+			char shm_env[64];
+			snprintf(shm_env, sizeof(shm_env),
+				 "slots=%u slot_size=%u",
+				 ring->hdr->slots,
+				 ring->hdr->slot_size);
+			setenv("CAMERA_RELAY_SHM", shm_env, 1);
+			dup2(ring->mem_fd, 3);
+			dup2(ring->event_fd, 4);
+		} else {
+			close(pipefd[0]);
+			dup2(pipefd[1], 3);
+			close(pipefd[1]);
+		}
 		int devnull = open("/dev/null", O_WRONLY);
 		if (devnull >= 0) {
 			dup2(devnull, STDOUT_FILENO);
@@ -265,10 +1634,13 @@ static int start_pipeline(char **cmd, pid_t *child_pid)
 		_exit(127);
 	}
 
-	/* Parent: close write end, return read end */
-	close(pipefd[1]);
+	/* Parent: close write end, hand back read end */
+	if (!ring) {
+		close(pipefd[1]);
+		*pipe_fd = pipefd[0];
+	}
 	*child_pid = pid;
-	return pipefd[0];
+	return 0;
 }
 
 /* Stop pipeline subprocess and reap it. */
@@ -292,6 +1664,97 @@ static void stop_pipeline(pid_t pid, int pipe_fd)
 	waitpid(pid, NULL, 0);
 }
 
+/*
+ * epoll/timerfd event-loop plumbing. The main loop sleeps in a
+ * single epoll_wait; all periodic work hangs off timerfds so there
+ * are no poll timeouts or usleep naps — the process is fully asleep
+ * whenever nothing is happening (this daemon runs 24/7 on battery).
+ */
+enum {
+	EV_HEART,	/* 1s heartbeat timer */
+	EV_VERIFY,	/* one-shot client-verification timer */
+	EV_STANDBY,	/* hot-standby expiry timer */
+	EV_DEV,		/* v4l2loopback event (POLLPRI) */
+	EV_INO,		/* inotify activity on the device node */
+	EV_PIPE,	/* pipeline pipe readable */
+	EV_RING,	/* shm ring eventfd signalled */
+	EV_STALL,	/* frame-arrival deadline expired */
+	EV_EVSOCK,	/* event-socket subscriber connecting */
+	EV_URING,	/* io_uring completion eventfd signalled */
+};
+
+/*
+ * Pipeline supervisor. A frame-arrival deadline timer replaces the
+ * shell watchdog's minute-granularity polling: the first frame of a
+ * session gets STALL_FIRST_MS (sensor bring-up takes 2-3s), then the
+ * deadline is re-armed on every frame. Embed mode re-arms only on
+ * the 1s heartbeat, so its deadline leaves headroom. Failed or
+ * stalled sessions restart with exponential backoff while clients
+ * remain, announced as RESTART lines on the stdout protocol.
+ */
+#define STALL_FIRST_MS		10000
+#define STALL_MS		500
+#define STALL_EMBED_MS		3000
+#define BACKOFF_BASE_MS		250
+#define BACKOFF_MAX_MS		8000
+
+static int ep_add(int ep, int fd, uint32_t events, uint32_t id)
+{
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = events;
+	ev.data.u32 = id;
+	return epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void ep_del(int ep, int fd)
+{
+	epoll_ctl(ep, EPOLL_CTL_DEL, fd, NULL);
+}
+
+/* Arm a timerfd in milliseconds; ms == 0 disarms. */
+static void timer_arm(int tfd, int ms, int periodic)
+{
+	struct itimerspec its;
+	memset(&its, 0, sizeof(its));
+	its.it_value.tv_sec = ms / 1000;
+	its.it_value.tv_nsec = (long)(ms % 1000) * 1000000L;
+	if (periodic)
+		its.it_interval = its.it_value;
+	timerfd_settime(tfd, 0, &its, NULL);
+}
+
+static void timer_drain(int tfd)
+{
+	uint64_t ticks;
+	(void)!read(tfd, &ticks, sizeof(ticks));
+}
+
+/* Start the relay pipeline in the configured mode. Exec mode sets
+ * *pipe_fd (pipe transport) and *child_pid; embed mode leaves them
+ * -1/0. Returns 0 on success, -1 on failure. */
+static int pipeline_up(int use_embed, char **cmd,
+		       struct shm_ring *ring, int *pipe_fd,
+		       pid_t *child_pid)
+{
+	if (use_embed) {
+		*pipe_fd = -1;
+		*child_pid = 0;
+		return embed_start(cmd);
+	}
+	if (ring)
+		shm_ring_reset(ring);
+	return start_pipeline(cmd, child_pid, ring, pipe_fd);
+}
+
+static void pipeline_down(int use_embed, pid_t child_pid, int pipe_fd)
+{
+	if (use_embed)
+		embed_stop();
+	else
+		stop_pipeline(child_pid, pipe_fd);
+}
+
 int main(int argc, char *argv[])
 {
 	const char *device;
@@ -301,6 +1764,10 @@ int main(int argc, char *argv[])
 	if (argc < 4) {
 		fprintf(stderr,
 			"Usage: %s <device> <width> <height>"
+			" [--io=write|mmap|splice|uring] [--embed] [--drop]"
+			" [--standby=SEC] [--format=yuy2|nv12|mjpeg]"
+			" [--transport=pipe|shm] [--mirror=DEV ...]"
+			" [--convert=nv12-yuy2|uyvy-yuy2]"
 			" -- <pipeline command...>\n", argv[0]);
 		return 1;
 	}
@@ -308,45 +1775,195 @@ int main(int argc, char *argv[])
 	device = argv[1];
 	width = atoi(argv[2]);
 	height = atoi(argv[3]);
-	frame_size = width * height * 2;  /* YUY2: 2 bytes/pixel */
 
-	/* Find pipeline command after "--" */
+	/* Options and pipeline command after "--" */
+	enum io_mode io = IO_WRITE;
+	int use_embed = 0;
+	int use_shm = 0;
+	const char *convert_name = NULL;
+	int drop_late = 0;
+	int standby_sec = 0;
+	const struct relay_format *rfmt = &relay_formats[0]; /* yuy2 */
 	char **pipeline_cmd = NULL;
 	for (int i = 4; i < argc; i++) {
+		if (strcmp(argv[i], "--io=mmap") == 0) {
+			io = IO_MMAP;
+			continue;
+		}
+		if (strcmp(argv[i], "--io=write") == 0) {
+			io = IO_WRITE;
+			continue;
+		}
+		if (strcmp(argv[i], "--io=splice") == 0) {
+			io = IO_SPLICE;
+			continue;
+		}
+		if (strcmp(argv[i], "--io=uring") == 0) {
+			io = IO_URING;
+			continue;
+		}
+		if (strcmp(argv[i], "--embed") == 0) {
+			use_embed = 1;
+			continue;
+		}
+		if (strcmp(argv[i], "--drop") == 0) {
+			drop_late = 1;
+			continue;
+		}
+		if (strncmp(argv[i], "--convert=", 10) == 0) {
+			convert_name = argv[i] + 10;
+			continue;
+		}
+		if (strncmp(argv[i], "--mirror=", 9) == 0) {
+			if (n_mirrors >= MAX_MIRRORS) {
+				fprintf(stderr,
+					"ERROR: Too many mirrors"
+					" (max %d)\n", MAX_MIRRORS);
+				return 1;
+			}
+			mirrors[n_mirrors].path = argv[i] + 9;
+			mirrors[n_mirrors].fd = -1;
+			n_mirrors++;
+			continue;
+		}
+		if (strcmp(argv[i], "--transport=shm") == 0) {
+			use_shm = 1;
+			continue;
+		}
+		if (strcmp(argv[i], "--transport=pipe") == 0) {
+			use_shm = 0;
+			continue;
+		}
+		if (strncmp(argv[i], "--standby=", 10) == 0) {
+			standby_sec = atoi(argv[i] + 10);
+			continue;
+		}
+		if (strncmp(argv[i], "--format=", 9) == 0) {
+			rfmt = lookup_format(argv[i] + 9);
+			if (!rfmt) {
+				fprintf(stderr,
+					"ERROR: Unknown format '%s'"
+					" (yuy2, nv12, mjpeg)\n",
+					argv[i] + 9);
+				return 1;
+			}
+			continue;
+		}
 		if (strcmp(argv[i], "--") == 0 && i + 1 < argc) {
 			pipeline_cmd = &argv[i + 1];
 			break;
 		}
 	}
+#ifndef HAVE_GST
+	if (use_embed) {
+		fprintf(stderr, "[monitor] Built without -DHAVE_GST,"
+			" ignoring --embed\n");
+		use_embed = 0;
+	}
+#endif
+#ifndef HAVE_IO_URING
+	if (io == IO_URING) {
+		fprintf(stderr, "[monitor] Built without io_uring"
+			" support, using write() I/O\n");
+		io = IO_WRITE;
+	}
+#endif
 	if (!pipeline_cmd) {
 		fprintf(stderr, "ERROR: No pipeline command given after --\n");
 		return 1;
 	}
 
+	/* Frame size (for MJPEG this is the accumulation-buffer cap) */
+	frame_size = width * height * rfmt->size_num / rfmt->size_den;
+
+	if (rfmt->compressed && io != IO_WRITE) {
+		fprintf(stderr, "[monitor] %s needs write() I/O,"
+			" ignoring --io\n", rfmt->name);
+		io = IO_WRITE;
+	}
+
+	if (use_embed && use_shm) {
+		fprintf(stderr, "[monitor] --embed has no subprocess,"
+			" ignoring --transport=shm\n");
+		use_shm = 0;
+	}
+
+	if (n_mirrors > 0 && io == IO_SPLICE) {
+		fprintf(stderr, "[monitor] Mirrors need frame data in"
+			" userspace, ignoring --io=splice\n");
+		io = IO_WRITE;
+	}
+
+	if (io == IO_URING && (use_shm || use_embed)) {
+		fprintf(stderr, "[monitor] --io=uring reads the pipeline"
+			" pipe, ignoring with --%s\n",
+			use_embed ? "embed" : "transport=shm");
+		io = IO_WRITE;
+	}
+
+	/*
+	 * In-monitor conversion: the pipeline delivers the input
+	 * format, the device (and black frames) stay YUY2.
+	 */
+	const struct converter *conv = NULL;
+	int in_frame_size = frame_size;
+	if (convert_name) {
+		if (rfmt->fourcc != V4L2_PIX_FMT_YUYV) {
+			fprintf(stderr, "[monitor] --convert targets"
+				" YUY2 output, ignoring with"
+				" --format=%s\n", rfmt->name);
+		} else if (use_embed) {
+			fprintf(stderr, "[monitor] --embed negotiates"
+				" its own caps, ignoring"
+				" --convert\n");
+		} else {
+			conv = lookup_converter(convert_name, width);
+			if (!conv) {
+				fprintf(stderr,
+					"ERROR: Unknown conversion"
+					" '%s'\n", convert_name);
+				return 1;
+			}
+			in_frame_size = width * height *
+				conv->in_num / conv->in_den;
+			if (io == IO_SPLICE || io == IO_URING) {
+				fprintf(stderr, "[monitor] Conversion"
+					" runs per frame in userspace,"
+					" ignoring --io=%s\n",
+					io == IO_SPLICE ? "splice" :
+					"uring");
+				io = IO_WRITE;
+			}
+		}
+	}
+
 	setvbuf(stdout, NULL, _IOLBF, 0);
 
 	signal(SIGINT, handle_signal);
 	signal(SIGTERM, handle_signal);
 	signal(SIGPIPE, SIG_IGN);
 
-	/* Allocate YUY2 black frame (BT.601: Y=0x10, U=V=0x80) */
+	/* Precompute the idle/black frame for the chosen format */
 	char *black_frame = malloc(frame_size);
 	if (!black_frame) {
 		fprintf(stderr, "ERROR: Cannot allocate frame buffer\n");
 		return 1;
 	}
-	for (int i = 0; i < frame_size; i += 4) {
-		black_frame[i + 0] = 0x10;
-		black_frame[i + 1] = 0x80;
-		black_frame[i + 2] = 0x10;
-		black_frame[i + 3] = 0x80;
-	}
+	fill_black_frame(black_frame, rfmt, width, height);
+	if (rfmt->compressed)
+		fprintf(stderr,
+			"[monitor] %s: no idle frames — clients see"
+			" frames only while the pipeline runs\n",
+			rfmt->name);
 
 	/* Allocate relay frame buffer */
 	char *frame_buf = malloc(frame_size);
-	if (!frame_buf) {
+	char *conv_buf = conv ? malloc(in_frame_size) : NULL;
+	if (!frame_buf || (conv && !conv_buf)) {
 		fprintf(stderr, "ERROR: Cannot allocate relay buffer\n");
 		free(black_frame);
+		free(frame_buf);
+		free(conv_buf);
 		return 1;
 	}
 
@@ -357,18 +1974,86 @@ int main(int argc, char *argv[])
 			device, strerror(errno));
 		free(black_frame);
 		free(frame_buf);
+		free(conv_buf);
 		return 1;
 	}
 	pid_t our_pid = getpid();
 
+	/* Event-driven client tracking (inotify on the device node) */
+	struct tracker trk;
+	if (tracker_init(&trk, device) == 0)
+		fprintf(stderr,
+			"[monitor] inotify client tracking active\n");
+	else
+		fprintf(stderr,
+			"[monitor] inotify unavailable, /proc scans"
+			" run on every check\n");
+
+	/* Shared-memory ring transport (one ring, reused per session) */
+	struct shm_ring ring;
+	memset(&ring, 0, sizeof(ring));
+	ring.mem_fd = -1;
+	ring.event_fd = -1;
+	if (use_shm && shm_ring_create(&ring, in_frame_size) < 0) {
+		fprintf(stderr, "[monitor] shm ring unavailable,"
+			" using pipe transport\n");
+		use_shm = 0;
+	}
+
 	/* Open writer and set up device */
-	int fd = open_writer(device, width, height, frame_size, black_frame);
+	int fd = open_writer(device, width, height, rfmt->fourcc,
+			     frame_size);
 	if (fd < 0) {
 		free(black_frame);
 		free(frame_buf);
+		free(conv_buf);
 		return 1;
 	}
 
+	/*
+	 * Mirror devices share the primary's format and get every
+	 * frame (including black keepalives) via mirror_put(). Their
+	 * dev_ts join the client-tracking watch list so a consumer on
+	 * any output device starts the one shared pipeline.
+	 */
+	dev_t watch_devs[1 + MAX_MIRRORS];
+	int n_watch = 1;
+	watch_devs[0] = dev_stat.st_rdev;
+	for (int i = 0; i < n_mirrors; i++) {
+		struct stat mst;
+		mirrors[i].fd = open_writer(mirrors[i].path, width,
+					    height, rfmt->fourcc,
+					    frame_size);
+		if (mirrors[i].fd < 0 ||
+		    fstat(mirrors[i].fd, &mst) < 0) {
+			fprintf(stderr,
+				"[monitor] Mirror %s unavailable,"
+				" skipping\n", mirrors[i].path);
+			if (mirrors[i].fd >= 0)
+				close(mirrors[i].fd);
+			mirrors[i].fd = -1;
+			continue;
+		}
+		watch_devs[n_watch++] = mst.st_rdev;
+		if (trk.ino_fd >= 0)
+			inotify_add_watch(trk.ino_fd, mirrors[i].path,
+					  IN_OPEN | IN_CLOSE);
+		fprintf(stderr, "[monitor] Mirroring to %s\n",
+			mirrors[i].path);
+	}
+
+	/* Set up the chosen I/O path and prime the device with one
+	 * black frame so ready_for_capture=1 from the start. */
+	struct out_mmap omap;
+	memset(&omap, 0, sizeof(omap));
+	if (io == IO_MMAP && out_mmap_setup(fd, &omap) < 0)
+		io = IO_WRITE;
+	if (!rfmt->compressed &&
+	    put_frame(fd, io, &omap, black_frame, frame_size) < 0)
+		fprintf(stderr, "[monitor] Initial write warning: %s\n",
+			strerror(errno));
+	embed_set_output(fd, io, &omap, frame_size);
+
 	/* Try event-based client detection */
 	__u32 event_type = try_subscribe_events(fd);
 	int use_events = (event_type != 0);
@@ -383,31 +2068,84 @@ int main(int argc, char *argv[])
 	fprintf(stderr, "[monitor] Watching %s (%dx%d) dev=%u:%u\n",
 		device, width, height,
 		major(dev_stat.st_rdev), minor(dev_stat.st_rdev));
+	evsock_init();
 	printf("READY\n");
+	evsock_emit(RELAY_EV_READY, 0, 0, 0);
 
 	/*
-	 * Main loop: IDLE and RELAY states.
+	 * Main loop: IDLE and RELAY states around one epoll instance.
 	 *
-	 * IDLE: write black frames at ~1fps, watch for client connections.
-	 *       Writer fd is always held — ready_for_capture never drops.
-	 *       Uses v4l2loopback events when available (zero CPU), with
-	 *       /proc verification to filter PipeWire false starts.
-	 *       Falls back to /proc polling if no event support.
+	 * IDLE: a 1s heartbeat timerfd writes the black frame that keeps
+	 *       ready_for_capture=1; between ticks the process sleeps
+	 *       fully in epoll_wait. Client connects surface as
+	 *       v4l2loopback events or inotify activity and are acted on
+	 *       immediately; if an event fires but no client is counted
+	 *       yet (PipeWire probes open briefly), a 100ms one-shot
+	 *       verify timer re-checks instead of sleeping in the event
+	 *       path.
 	 *
-	 * RELAY: pipeline subprocess is running, outputting frames to a
-	 *        pipe. Read frames from pipe, write to device. Black
-	 *        frames are written during pipeline startup (before first
-	 *        real frame arrives). Monitor /proc for client disconnect.
+	 * RELAY: the pipeline pipe is registered edge-triggered and
+	 *        non-blocking; frames are accumulated across reads and
+	 *        written on completion, so device and client events stay
+	 *        visible between frames. The heartbeat carries the ~1s
+	 *        client-count check and embed-mode stall detection. In
+	 *        embed mode frames are pushed by the appsink callback
+	 *        and never pass through this loop.
 	 *
 	 * After each pipeline stop, the device fd is closed and re-opened
 	 * to reset v4l2loopback's event queue (0.12.7 events break
 	 * permanently after the first pipeline cycle otherwise).
 	 */
 	int relay_active = 0;
-	int prev_clients = 0;
+	int standby = 0;      /* pipeline hot, clients gone */
 	pid_t child_pid = 0;
 	int pipe_fd = -1;
 	int rapid_fails = 0;  /* pipeline failures without success */
+	int idle_ticks = 0;   /* heartbeats without clients in RELAY */
+	int had_clients = 0;  /* session ever saw a client */
+	int fill = 0;         /* bytes accumulated of current frame */
+	int fill_idx = -1;    /* claimed mmap buffer, -1 = none */
+	long drop_count = 0;  /* late frames dropped (--drop) */
+	long drop_reported = 0;
+#ifdef HAVE_IO_URING
+	struct uring urg;     /* per-session ring (--io=uring) */
+	memset(&urg, 0, sizeof(urg));
+	urg.fd = -1;
+	urg.event_fd = -1;
+	int uring_hup = 0;    /* pipe hangup seen via the ring poll */
+#endif
+	int stat_ticks = 0;   /* heartbeats since the last STATS line */
+	unsigned long seen_frames = 0;   /* frame count at stall arm */
+	long long backoff_until = 0;     /* ms; no restart before this */
+
+	int ep = epoll_create1(EPOLL_CLOEXEC);
+	int heart_fd = timerfd_create(CLOCK_MONOTONIC,
+				      TFD_NONBLOCK | TFD_CLOEXEC);
+	int verify_fd = timerfd_create(CLOCK_MONOTONIC,
+				       TFD_NONBLOCK | TFD_CLOEXEC);
+	int standby_fd = timerfd_create(CLOCK_MONOTONIC,
+					TFD_NONBLOCK | TFD_CLOEXEC);
+	int stall_fd = timerfd_create(CLOCK_MONOTONIC,
+				      TFD_NONBLOCK | TFD_CLOEXEC);
+	if (ep < 0 || heart_fd < 0 || verify_fd < 0 || standby_fd < 0 ||
+	    stall_fd < 0) {
+		fprintf(stderr, "ERROR: epoll/timerfd setup: %s\n",
+			strerror(errno));
+		return 1;
+	}
+	timer_arm(heart_fd, 1000, 1);
+	ep_add(ep, heart_fd, EPOLLIN, EV_HEART);
+	ep_add(ep, verify_fd, EPOLLIN, EV_VERIFY);
+	ep_add(ep, standby_fd, EPOLLIN, EV_STANDBY);
+	ep_add(ep, stall_fd, EPOLLIN, EV_STALL);
+	if (trk.ino_fd >= 0)
+		ep_add(ep, trk.ino_fd, EPOLLIN, EV_INO);
+	if (use_shm)
+		ep_add(ep, ring.event_fd, EPOLLIN, EV_RING);
+	if (use_events)
+		ep_add(ep, fd, EPOLLPRI, EV_DEV);
+	if (evsock_fd >= 0)
+		ep_add(ep, evsock_fd, EPOLLIN, EV_EVSOCK);
 
 	if (use_events) {
 		/* Drain initial event (non-blocking — may not exist) */
@@ -419,286 +2157,903 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	int idle_polls = 0;  /* count poll timeouts for /proc fallback */
-
 	while (running) {
+		struct epoll_event evs[8];
+		int nev = epoll_wait(ep, evs, 8, -1);
+		if (nev < 0) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "[monitor] epoll_wait: %s\n",
+				strerror(errno));
+			break;
+		}
+
+		int check_clients = 0;	/* device saw open/close activity */
+		int heartbeat = 0;
+		int pipe_ready = 0;
+		int pipe_hup = 0;
+		int ring_ready = 0;
+		int uring_ready = 0;
+#ifndef HAVE_IO_URING
+		(void)uring_ready;
+#endif
+		int need_stop = 0;
+		int standby_expired = 0;
+		int stall_fired = 0;
+
+		for (int i = 0; i < nev; i++) {
+			switch (evs[i].data.u32) {
+			case EV_HEART:
+				timer_drain(heart_fd);
+				heartbeat = 1;
+				break;
+			case EV_VERIFY:
+				timer_drain(verify_fd);
+				check_clients = 1;
+				break;
+			case EV_STANDBY:
+				timer_drain(standby_fd);
+				standby_expired = 1;
+				break;
+			case EV_STALL:
+				timer_drain(stall_fd);
+				stall_fired = 1;
+				break;
+			case EV_DEV: {
+				struct v4l2_event ev;
+				memset(&ev, 0, sizeof(ev));
+				if (xioctl(fd, VIDIOC_DQEVENT, &ev) == 0)
+					check_clients = 1;
+				break;
+			}
+			case EV_INO:
+				if (tracker_drain(&trk))
+					check_clients = 1;
+				break;
+			case EV_PIPE:
+				pipe_ready = 1;
+				if (evs[i].events &
+				    (EPOLLHUP | EPOLLRDHUP | EPOLLERR))
+					pipe_hup = 1;
+				break;
+			case EV_RING:
+				ring_ready = 1;
+				break;
+			case EV_EVSOCK:
+				evsock_accept();
+				break;
+			case EV_URING:
+				uring_ready = 1;
+				break;
+			}
+		}
+
+		if (heartbeat && ++stat_ticks >= STATS_INTERVAL_SEC) {
+			stat_ticks = 0;
+			stats_emit(drop_count, trk.clients);
+			evsock_emit(RELAY_EV_STATS, trk.clients,
+				    drop_count, 0);
+		}
+
 		if (!relay_active) {
 			/*
-			 * IDLE state: write black frame, watch for clients.
-			 * The write keeps ready_for_capture=1 so clients
-			 * can STREAMON at any time.
+			 * IDLE state: black frame on each heartbeat,
+			 * start the pipeline the moment a client is
+			 * counted.
 			 */
-			(void)!write(fd, black_frame, frame_size);
-
-			int client_detected = 0;
+			int clients = -1;
 
-			if (use_events) {
-				/*
-				 * Wait for v4l2loopback event (zero CPU).
-				 * Use 2s timeout. On timeout, fall back to
-				 * /proc check — events may be broken after
-				 * a pipeline cycle on some v4l2loopback
-				 * versions.
-				 */
-				struct pollfd pfd = {
-					.fd = fd, .events = POLLPRI
-				};
-				int ret = poll(&pfd, 1, 2000);
-
-				if (ret > 0 && (pfd.revents & POLLPRI)) {
-					struct v4l2_event ev;
-					memset(&ev, 0, sizeof(ev));
-					if (xioctl(fd, VIDIOC_DQEVENT,
-						   &ev) == 0) {
-						/*
-						 * Verify via /proc — PipeWire
-						 * briefly opens the device
-						 * during scanning, causing
-						 * false events.
-						 */
-						usleep(100000);
-						int clients =
-							count_other_openers(
-							dev_stat.st_rdev,
-							our_pid, 0);
-						fprintf(stderr,
-							"[monitor] Event"
-							" fired, /proc"
-							" clients=%d\n",
-							clients);
-						if (clients > 0)
-							client_detected = 1;
-					}
-					idle_polls = 0;
-				} else {
-					/*
-					 * Event timeout — check /proc as
-					 * fallback. Events may be broken
-					 * after fd re-open on some versions.
-					 */
-					idle_polls++;
-					int clients = count_other_openers(
-						dev_stat.st_rdev,
-						our_pid, 0);
-					if (clients > 0) {
-						fprintf(stderr,
-							"[monitor] /proc"
-							" fallback:"
-							" clients=%d\n",
-							clients);
-						client_detected = 1;
-					}
-				}
-			} else {
-				/*
-				 * No event support — poll /proc every 2s.
-				 */
-				int clients = count_other_openers(
-					dev_stat.st_rdev, our_pid, 0);
-				if (clients > 0 && prev_clients == 0)
-					client_detected = 1;
-				prev_clients = clients;
-				if (!client_detected)
-					sleep(2);
+			if (check_clients) {
+				clients = tracker_scan(&trk,
+					watch_devs, n_watch, our_pid, 0);
+				fprintf(stderr,
+					"[monitor] Activity, /proc"
+					" clients=%d\n", clients);
+				if (clients == 0)
+					timer_arm(verify_fd, 100, 0);
+			} else if (heartbeat) {
+				if (!rfmt->compressed &&
+				    put_frame(fd, io, &omap,
+					      black_frame,
+					      frame_size) == 0)
+					stats.black++;
+				clients = tracker_refresh(&trk,
+					watch_devs, n_watch, our_pid, 0);
 			}
 
-			if (client_detected) {
+			if (clients > 0 &&
+			    (long long)(now_ns() / 1000000) <
+			    backoff_until) {
+				/* Restart backoff pending — the
+				 * verify timer re-enters here when
+				 * it expires. */
+			} else if (clients > 0) {
 				fprintf(stderr,
 					"[monitor] Client connected"
 					" — starting pipeline\n");
-				pipe_fd = start_pipeline(pipeline_cmd,
-							 &child_pid);
-				if (pipe_fd < 0) {
+				if (pipeline_up(use_embed, pipeline_cmd,
+						use_shm ? &ring : NULL,
+						&pipe_fd, &child_pid) < 0) {
 					fprintf(stderr,
 						"[monitor] Failed to"
 						" start pipeline\n");
 					continue;
 				}
 				relay_active = 1;
-				prev_clients = 0;
+				idle_ticks = 0;
+				had_clients = 0;
+				fill = 0;
+				fill_idx = -1;
+				seen_frames = stats.frames;
+				timer_arm(stall_fd, STALL_FIRST_MS, 0);
+				if (pipe_fd >= 0) {
+					fcntl(pipe_fd, F_SETFL,
+					      O_NONBLOCK);
+#ifdef HAVE_IO_URING
+					if (io == IO_URING) {
+						uring_hup = 0;
+						if (uring_start(&urg,
+								pipe_fd,
+								frame_size)
+						    == 0)
+							ep_add(ep,
+							       urg.event_fd,
+							       EPOLLIN,
+							       EV_URING);
+						else
+							io = IO_WRITE;
+					}
+#endif
+					if (io != IO_URING)
+						ep_add(ep, pipe_fd,
+						       EPOLLIN | EPOLLRDHUP |
+						       EPOLLET, EV_PIPE);
+				}
+				timer_arm(verify_fd, 0, 0);
 				printf("START\n");
+				evsock_emit(RELAY_EV_START, clients,
+					    drop_count, 0);
 			}
-		} else {
+			continue;
+		}
+
+		/*
+		 * RELAY state: drain the (edge-triggered) pipe,
+		 * accumulating into the destination frame and writing
+		 * each completed frame to the device. During pipeline
+		 * startup the last IDLE black frame keeps the device
+		 * active until the first real frame arrives.
+		 */
+		if (use_shm && ring_ready) {
 			/*
-			 * RELAY state: read frames from pipeline pipe,
-			 * write to device. During pipeline startup
-			 * (before first frame), write black frames to
-			 * keep the device active for clients.
+			 * Consume ring slots up to the producer's
+			 * head. One eventfd read per batch, one device
+			 * write per frame — no per-frame pipe I/O.
 			 */
-			int need_stop = 0;
+			uint64_t cnt;
+			(void)!read(ring.event_fd, &cnt, sizeof(cnt));
+
+			uint32_t head = ring.hdr->head;
+			uint32_t tail = ring.hdr->tail;
+			if (drop_late && head - tail > 1) {
+				drop_count += head - tail - 1;
+				tail = head - 1;
+			}
+			while (tail != head) {
+				uint32_t slot = tail % ring.hdr->slots;
+				uint32_t used = ring.hdr->used[slot];
+				const char *data = ring.slots +
+					(size_t)slot *
+					ring.hdr->slot_size;
+				if (conv &&
+				    used == (uint32_t)in_frame_size) {
+					conv->fn(frame_buf, data,
+						 width, height);
+					put_frame(fd, io, &omap,
+						  frame_buf,
+						  frame_size);
+				} else if (!conv && used > 0 &&
+					   used <= (uint32_t)frame_size)
+					put_frame(fd, io, &omap,
+						  data, used);
+				tail++;
+				rapid_fails = 0;
+			}
+			__sync_synchronize();
+			ring.hdr->tail = tail;
+		}
 
+#ifdef HAVE_IO_URING
+		if (io == IO_URING && uring_ready && urg.fd >= 0) {
 			/*
-			 * Tight blocking read — no poll().
-			 * read_full blocks until a full frame arrives,
-			 * then we write immediately. This is critical
-			 * for low latency — poll() between frames
-			 * causes periodic stutter.
-			 *
-			 * During pipeline startup (~2-3s), read_full
-			 * blocks until the first frame arrives. The
-			 * last black frame written in IDLE state keeps
-			 * the device active for clients during this
-			 * time. If the pipeline dies, read_full returns
-			 * short and we handle it below.
+			 * Drain completions: one eventfd read per batch,
+			 * then walk the CQ. Frame writes complete here;
+			 * the multishot pipe poll says when there is data
+			 * for the next linked read→write chain.
 			 */
-			int n = read_full(pipe_fd, frame_buf,
-					  frame_size);
-			if (n == frame_size) {
-				(void)!write(fd, frame_buf,
-					     frame_size);
-				rapid_fails = 0;
-			} else {
+			uint64_t ucnt;
+			(void)!read(urg.event_fd, &ucnt, sizeof(ucnt));
+
+			int uring_failed = 0;
+			unsigned head = *urg.cq_head;
+			while (head != __atomic_load_n(urg.cq_tail,
+						       __ATOMIC_ACQUIRE)) {
+				struct io_uring_cqe *c =
+					&urg.cqes[head & *urg.cq_mask];
+				int buf = c->user_data & 0xff;
+
+				switch (c->user_data & ~0xffull) {
+				case URING_UD_POLL:
+					if (c->res < 0) {
+						need_stop = 1;
+						break;
+					}
+					if (c->res & (POLLHUP | POLLRDHUP |
+						      POLLERR))
+						uring_hup = 1;
+					if (!(c->flags &
+					      IORING_CQE_F_MORE) &&
+					    !uring_hup)
+						uring_arm_poll(&urg,
+							       pipe_fd);
+					break;
+				case URING_UD_READ:
+					urg.pending_reads--;
+					if (c->res == frame_size)
+						break;	/* write is linked */
+					if (c->res == 0) {
+						uring_hup = 1;
+						break;
+					}
+					fprintf(stderr,
+						"[monitor] uring read"
+						" (res=%d): %s\n", c->res,
+						c->res < 0 ?
+						strerror(-c->res) :
+						"short frame");
+					need_stop = 1;
+					break;
+				case URING_UD_WRITE:
+					urg.buf_busy[buf] = 0;
+					urg.inflight--;
+					if (c->res == frame_size) {
+						mirror_put(urg.bufs[buf],
+							   frame_size);
+						stats.frames++;
+						stats_lat_record(now_ns() -
+							urg.buf_t0[buf]);
+						rapid_fails = 0;
+						break;
+					}
+					if (c->res == -ECANCELED)
+						break;	/* severed link */
+					if (c->res == -EINVAL ||
+					    c->res == -EOPNOTSUPP ||
+					    c->res == -EBADF) {
+						/* Device refuses uring
+						 * writes — salvage this
+						 * frame, then fall back
+						 * for good. */
+						put_frame(fd, IO_WRITE,
+							  &omap,
+							  urg.bufs[buf],
+							  frame_size);
+						uring_failed = 1;
+						break;
+					}
+					fprintf(stderr,
+						"[monitor] uring write"
+						" (res=%d): %s\n", c->res,
+						c->res < 0 ?
+						strerror(-c->res) :
+						"short write");
+					need_stop = 1;
+					break;
+				}
+				head++;
+			}
+			__atomic_store_n(urg.cq_head, head,
+					 __ATOMIC_RELEASE);
+
+			if (uring_failed && !need_stop) {
+				fprintf(stderr,
+					"[monitor] Device rejects io_uring"
+					" writes, falling back to write()"
+					" I/O\n");
+				ep_del(ep, urg.event_fd);
+				uring_stop(&urg);
+				io = IO_WRITE;
+				ep_add(ep, pipe_fd,
+				       EPOLLIN | EPOLLRDHUP | EPOLLET,
+				       EV_PIPE);
+			} else if (!need_stop) {
+				/*
+				 * Submit while a buffer is free and the
+				 * pipe holds the bytes for every not-yet-
+				 * reaped read plus one more whole frame —
+				 * that way reads complete inline, in
+				 * order, and never short.
+				 */
+				for (;;) {
+					int avail = 0, buf = -1;
+					for (int i = 0; i < URING_NBUFS;
+					     i++)
+						if (!urg.buf_busy[i])
+							buf = i;
+					if (buf < 0)
+						break;
+					if (ioctl(pipe_fd, FIONREAD,
+						  &avail) < 0)
+						break;
+					if (avail <
+					    (urg.pending_reads + 1) *
+					    frame_size)
+						break;
+					if (drop_late &&
+					    urg.pending_reads == 0 &&
+					    avail >= 2 * frame_size) {
+						/* Newer frame queued —
+						 * discard this one. */
+						int left = frame_size;
+						while (left > 0) {
+							ssize_t d = read(
+								pipe_fd,
+								frame_buf,
+								left);
+							if (d <= 0)
+								break;
+							left -= d;
+						}
+						drop_count++;
+						continue;
+					}
+					uring_queue_frame(&urg, pipe_fd,
+							  fd, frame_size,
+							  buf);
+				}
+
+				if (uring_hup && urg.inflight == 0) {
+					int avail = 0;
+					ioctl(pipe_fd, FIONREAD, &avail);
+					if (avail < frame_size) {
+						fprintf(stderr,
+							"[monitor]"
+							" Pipeline EOF\n");
+						need_stop = 1;
+					}
+				}
+			}
+		}
+#endif /* HAVE_IO_URING */
+
+		if (pipe_ready && pipe_fd >= 0 && rfmt->compressed) {
+			/*
+			 * MJPEG passthrough: frames are variable-size,
+			 * so accumulate and emit each complete JPEG
+			 * (up to and including the FFD9 EOI marker) as
+			 * one device write.
+			 */
+			for (;;) {
+				ssize_t r = read(pipe_fd, frame_buf + fill,
+						 frame_size - fill);
+				if (r > 0) {
+					int scan = fill > 0 ? fill - 1 : 0;
+					fill += r;
+					for (int j = scan; j + 1 < fill;
+					     j++) {
+						if ((unsigned char)
+						    frame_buf[j] != 0xFF ||
+						    (unsigned char)
+						    frame_buf[j + 1] != 0xD9)
+							continue;
+						put_frame(fd, IO_WRITE,
+							  &omap, frame_buf,
+							  j + 2);
+						memmove(frame_buf,
+							frame_buf + j + 2,
+							fill - (j + 2));
+						fill -= j + 2;
+						rapid_fails = 0;
+						j = -1;	/* rescan */
+					}
+					if (fill == frame_size) {
+						fprintf(stderr,
+							"[monitor] MJPEG"
+							" frame exceeds"
+							" buffer,"
+							" dropping\n");
+						fill = 0;
+					}
+					continue;
+				}
+				if (r < 0 && (errno == EAGAIN ||
+					      errno == EWOULDBLOCK))
+					break;
+				if (r < 0 && errno == EINTR)
+					continue;
+				fprintf(stderr,
+					"[monitor] Pipeline EOF/error\n");
+				need_stop = 1;
+				break;
+			}
+		} else if (pipe_ready && pipe_fd >= 0 && io == IO_SPLICE) {
+			/*
+			 * Splice fast path: once the (8MB) pipe holds
+			 * a complete frame, move its pages to the
+			 * device in a single splice() — frame data
+			 * never enters our address space. FIONREAD
+			 * gating keeps every device write one whole
+			 * frame, which v4l2loopback requires.
+			 */
+			for (;;) {
+				int avail = 0;
+				if (ioctl(pipe_fd, FIONREAD, &avail) < 0)
+					avail = 0;
+				if (avail < frame_size)
+					break;
+
+				if (drop_late &&
+				    avail >= 2 * frame_size) {
+					/* Newer frame queued — discard
+					 * this one into frame_buf. */
+					int left = frame_size;
+					while (left > 0) {
+						ssize_t d = read(pipe_fd,
+							frame_buf,
+							left < frame_size ?
+							left : frame_size);
+						if (d <= 0)
+							break;
+						left -= d;
+					}
+					drop_count++;
+					continue;
+				}
+
+				ssize_t r = splice(pipe_fd, NULL, fd,
+						   NULL, frame_size,
+						   SPLICE_F_MOVE);
+				if (r == frame_size) {
+					stats.frames++;
+					rapid_fails = 0;
+					continue;
+				}
+				if (r < 0 && errno == EINTR)
+					continue;
+				if (r < 0 && (errno == EINVAL ||
+					      errno == EBADF)) {
+					/* Device refuses splice —
+					 * permanent fallback before
+					 * any data moved. */
+					fprintf(stderr,
+						"[monitor] splice"
+						" unsupported (%s),"
+						" falling back to"
+						" write() I/O\n",
+						strerror(errno));
+					io = IO_WRITE;
+					break;
+				}
+				fprintf(stderr,
+					"[monitor] splice error"
+					" (r=%zd): %s\n",
+					r, strerror(errno));
+				need_stop = 1;
+				break;
+			}
+			if (pipe_hup && !need_stop) {
+				fprintf(stderr,
+					"[monitor] Pipeline EOF\n");
+				need_stop = 1;
+			}
+		} else if (pipe_ready && pipe_fd >= 0) {
+			for (;;) {
+				char *dst;
+				if (conv) {
+					/* Accumulate the input-format
+					 * frame; conversion is the
+					 * copy to the device buffer. */
+					dst = conv_buf;
+				} else if (io == IO_MMAP) {
+					if (fill_idx < 0) {
+						fill_idx = out_mmap_claim(
+							fd, &omap);
+						if (fill_idx < 0) {
+							need_stop = 1;
+							break;
+						}
+						fill = 0;
+					}
+					dst = omap.mem[fill_idx];
+				} else {
+					dst = frame_buf;
+				}
+
+				ssize_t r = read(pipe_fd, dst + fill,
+						 in_frame_size - fill);
+				if (r > 0) {
+					fill += r;
+					if (fill == in_frame_size &&
+					    drop_late) {
+						/*
+						 * Latest frame wins: if a
+						 * newer complete frame is
+						 * already in the pipe,
+						 * drop this one (reuse the
+						 * same buffer) instead of
+						 * writing stale video.
+						 */
+						int avail = 0;
+						if (ioctl(pipe_fd, FIONREAD,
+							  &avail) == 0 &&
+						    avail >= in_frame_size) {
+							drop_count++;
+							fill = 0;
+							continue;
+						}
+					}
+					if (fill == in_frame_size &&
+					    conv) {
+						if (io == IO_MMAP) {
+							int idx =
+							out_mmap_claim(
+								fd, &omap);
+							if (idx < 0) {
+								need_stop = 1;
+								break;
+							}
+							unsigned long long
+							t0 = now_ns();
+							conv->fn(
+								omap.mem[idx],
+								conv_buf,
+								width,
+								height);
+							mirror_put(
+								omap.mem[idx],
+								frame_size);
+							out_mmap_submit(fd,
+								&omap, idx,
+								frame_size);
+							stats.frames++;
+							stats_lat_record(
+								now_ns() -
+								t0);
+						} else {
+							conv->fn(frame_buf,
+								conv_buf,
+								width,
+								height);
+							put_frame(fd,
+								IO_WRITE,
+								&omap,
+								frame_buf,
+								frame_size);
+						}
+						fill = 0;
+						rapid_fails = 0;
+					} else if (fill ==
+						   in_frame_size) {
+						if (io == IO_MMAP) {
+							unsigned long long
+							t0 = now_ns();
+							mirror_put(dst,
+								frame_size);
+							out_mmap_submit(fd,
+								&omap,
+								fill_idx,
+								frame_size);
+							stats.frames++;
+							stats_lat_record(
+								now_ns() -
+								t0);
+							fill_idx = -1;
+						} else {
+							put_frame(fd,
+								IO_WRITE,
+								&omap,
+								frame_buf,
+								frame_size);
+						}
+						fill = 0;
+						rapid_fails = 0;
+					}
+					continue;
+				}
+				if (r < 0 && (errno == EAGAIN ||
+					      errno == EWOULDBLOCK))
+					break;
+				if (r < 0 && errno == EINTR)
+					continue;
 				fprintf(stderr,
-					"[monitor] Pipeline"
-					" EOF/error (read=%d"
-					" of %d)\n",
-					n, frame_size);
+					"[monitor] Pipeline EOF/error"
+					" (read=%d of %d)\n",
+					fill, in_frame_size);
 				need_stop = 1;
+				break;
 			}
+		}
 
+		if (!need_stop && (heartbeat || check_clients)) {
 			/*
-			 * Check client count via /proc every ~1 second.
-			 * At ~30fps, check every 30th frame.
+			 * Client-count check: activity forces a scan,
+			 * the heartbeat only refreshes (cached unless
+			 * the consistency interval elapsed).
 			 */
-			static int check_tick = 0;
-			static int idle_ticks = 0;
-			static int had_clients = 0;
+			int clients = check_clients ?
+				tracker_scan(&trk, watch_devs, n_watch,
+					     our_pid, child_pid) :
+				tracker_refresh(&trk, watch_devs, n_watch,
+						our_pid, child_pid);
 
-			if (!need_stop && ++check_tick % 30 == 0) {
-				int clients = count_other_openers(
-					dev_stat.st_rdev, our_pid,
-					child_pid);
+			if (clients > 0)
+				had_clients = 1;
 
-				if (clients > 0)
-					had_clients = 1;
+			if (standby && clients > 0) {
+				/*
+				 * Rapid reconnect — the pipeline is
+				 * still hot, resume real frames
+				 * immediately (no sensor/ISP bring-up).
+				 */
+				fprintf(stderr,
+					"[monitor] Client reconnected"
+					" — resuming from standby\n");
+				timer_arm(standby_fd, 0, 0);
+				standby = 0;
+				idle_ticks = 0;
+				printf("START\n");
+				evsock_emit(RELAY_EV_START, clients,
+					    drop_count, 0);
+			}
 
+			if (heartbeat) {
 				if (clients <= 0)
 					idle_ticks++;
 				else
 					idle_ticks = 0;
+			}
 
-				/*
-				 * Stop when:
-				 * - Had clients and they're all gone
-				 *   for 3+ seconds
-				 * - Never saw any clients after 10
-				 *   seconds (false start from scan)
-				 */
-				if ((had_clients && idle_ticks >= 3) ||
-				    (!had_clients && idle_ticks >= 10))
+			/*
+			 * Stop when:
+			 * - Had clients and they're all gone for 3+
+			 *   seconds — unless hot standby is enabled,
+			 *   in which case the pipeline idles on for
+			 *   standby_sec awaiting a reconnect
+			 * - Never saw any clients after 10 seconds
+			 *   (false start from scan)
+			 */
+			if (had_clients && idle_ticks >= 3 && !standby) {
+				if (standby_sec > 0) {
+					fprintf(stderr,
+						"[monitor] Hot standby"
+						" for %ds\n",
+						standby_sec);
+					standby = 1;
+					timer_arm(standby_fd,
+						  standby_sec * 1000, 0);
+					printf("STOP\n");
+					evsock_emit(RELAY_EV_STOP, clients,
+						    drop_count, 0);
+				} else {
 					need_stop = 1;
+				}
+			} else if (!had_clients && idle_ticks >= 10) {
+				need_stop = 1;
 			}
 
-			if (need_stop) {
-				int clients = count_other_openers(
-					dev_stat.st_rdev, our_pid,
-					child_pid);
+			if (heartbeat && drop_count != drop_reported) {
 				fprintf(stderr,
-					"[monitor] Stopping pipeline"
-					" (clients=%d)\n", clients);
+					"[monitor] Late frames dropped:"
+					" %ld (+%ld)\n", drop_count,
+					drop_count - drop_reported);
+				drop_reported = drop_count;
+			}
 
-				stop_pipeline(child_pid, pipe_fd);
-				relay_active = 0;
-				pipe_fd = -1;
+			/*
+			 * The ring and embed transports have no pipe
+			 * EOF; the stall deadline below covers frames
+			 * ceasing to arrive, this catches a clean
+			 * child exit sooner.
+			 */
+			if (heartbeat && use_shm && child_pid > 0 &&
+			    waitpid(child_pid, NULL, WNOHANG) > 0) {
+				fprintf(stderr,
+					"[monitor] Pipeline exited\n");
 				child_pid = 0;
-				check_tick = 0;
-				idle_ticks = 0;
-				had_clients = 0;
-				prev_clients = 0;
+				need_stop = 1;
+			}
+		}
+
+		/*
+		 * Frame-arrival deadline: re-arm whenever frames made
+		 * progress this iteration; declare a stall when the
+		 * timer fires with none since it was armed. Embed
+		 * frames arrive on another thread and are only
+		 * observed here on heartbeats, hence the longer
+		 * deadline.
+		 */
+		if (relay_active && stats.frames != seen_frames) {
+			seen_frames = stats.frames;
+			timer_arm(stall_fd, use_embed ?
+				  STALL_EMBED_MS : STALL_MS, 0);
+		} else if (relay_active && stall_fired && !need_stop) {
+			fprintf(stderr,
+				"[monitor] Pipeline stalled (no frames"
+				" within deadline)\n");
+			need_stop = 1;
+		}
+
+		if (standby_expired && standby) {
+			fprintf(stderr,
+				"[monitor] Standby expired"
+				" — stopping pipeline\n");
+			need_stop = 1;
+		}
+
+		if (need_stop) {
+			/* STOP was already announced when standby
+			 * began — don't repeat it. */
+			int stop_quiet = standby;
+			standby = 0;
+			timer_arm(standby_fd, 0, 0);
+
+			int clients = tracker_scan(&trk,
+				watch_devs, n_watch, our_pid,
+				child_pid);
+			fprintf(stderr,
+				"[monitor] Stopping pipeline"
+				" (clients=%d)\n", clients);
+
+			if (pipe_fd >= 0)
+				ep_del(ep, pipe_fd);
+#ifdef HAVE_IO_URING
+			if (urg.fd >= 0) {
+				ep_del(ep, urg.event_fd);
+				uring_stop(&urg);
+			}
+#endif
+			pipeline_down(use_embed, child_pid, pipe_fd);
+			relay_active = 0;
+			pipe_fd = -1;
+			child_pid = 0;
+			idle_ticks = 0;
+			had_clients = 0;
+			fill = 0;
+			fill_idx = -1;
+			if (!stop_quiet) {
 				printf("STOP\n");
+				evsock_emit(RELAY_EV_STOP, clients,
+					    drop_count, 0);
+			}
 
-				/*
-				 * Re-open device to reset v4l2loopback
-				 * event queue. Without this, events
-				 * break permanently on 0.12.7 after the
-				 * first pipeline cycle.
-				 */
-				if (use_events) {
-					close(fd);
-					fd = open_writer(device, width,
-						height, frame_size,
-						black_frame);
-					if (fd < 0) {
-						fprintf(stderr,
-							"[monitor] "
-							"Re-open "
-							"failed!\n");
-						running = 0;
-						break;
-					}
-					event_type =
-						try_subscribe_events(fd);
-					if (event_type == 0) {
-						fprintf(stderr,
-							"[monitor] "
-							"Event re-sub"
-							" failed,"
-							" using /proc"
-							" polling\n");
-						use_events = 0;
-					} else {
-						/* Drain initial event
-						 * (non-blocking — may
-						 * not exist on all
-						 * v4l2loopback versions) */
-						struct pollfd pfd = {
-							.fd = fd,
-							.events = POLLPRI
-						};
-						if (poll(&pfd, 1, 200)
-						    > 0) {
-							struct v4l2_event ev;
-							memset(&ev, 0,
-							       sizeof(ev));
-							xioctl(fd,
-							       VIDIOC_DQEVENT,
-							       &ev);
-						}
-					}
+			/*
+			 * Re-open device to reset v4l2loopback
+			 * event queue. Without this, events
+			 * break permanently on 0.12.7 after the
+			 * first pipeline cycle.
+			 */
+			if (use_events) {
+				ep_del(ep, fd);
+				if (io == IO_MMAP)
+					out_mmap_teardown(fd, &omap);
+				close(fd);
+				fd = open_writer(device, width,
+					height, rfmt->fourcc,
+					frame_size);
+				if (fd < 0) {
+					fprintf(stderr,
+						"[monitor] "
+						"Re-open "
+						"failed!\n");
+					running = 0;
+					break;
 				}
-
-				/*
-				 * Check if clients remain. The IDLE
-				 * loop will catch them on the next
-				 * iteration, but checking here avoids
-				 * a brief gap.
-				 *
-				 * Stop retrying if the pipeline keeps
-				 * failing rapidly (e.g. syntax error).
-				 */
-				rapid_fails++;
-				int remaining = count_other_openers(
-					dev_stat.st_rdev, our_pid, 0);
-				if (remaining > 0 && rapid_fails < 3) {
+				if (io == IO_MMAP &&
+				    out_mmap_setup(fd, &omap) < 0)
+					io = IO_WRITE;
+				embed_set_output(fd, io, &omap,
+						 frame_size);
+				if (!rfmt->compressed)
+					put_frame(fd, io, &omap,
+						  black_frame,
+						  frame_size);
+				event_type =
+					try_subscribe_events(fd);
+				if (event_type == 0) {
 					fprintf(stderr,
-						"[monitor] %d client(s)"
-						" still connected"
-						" — restarting\n",
-						remaining);
-					pipe_fd = start_pipeline(
-						pipeline_cmd,
-						&child_pid);
-					if (pipe_fd >= 0) {
-						relay_active = 1;
-						printf("START\n");
+						"[monitor] "
+						"Event re-sub"
+						" failed,"
+						" using /proc"
+						" polling\n");
+					use_events = 0;
+				} else {
+					ep_add(ep, fd, EPOLLPRI,
+					       EV_DEV);
+					/* Drain initial event
+					 * (non-blocking — may
+					 * not exist on all
+					 * v4l2loopback versions) */
+					struct pollfd pfd = {
+						.fd = fd,
+						.events = POLLPRI
+					};
+					if (poll(&pfd, 1, 200)
+					    > 0) {
+						struct v4l2_event ev;
+						memset(&ev, 0,
+						       sizeof(ev));
+						xioctl(fd,
+						       VIDIOC_DQEVENT,
+						       &ev);
 					}
-				} else if (rapid_fails >= 3) {
-					fprintf(stderr,
-						"[monitor] Pipeline"
-						" failed %d times,"
-						" not retrying\n",
-						rapid_fails);
-					rapid_fails = 0;
 				}
 			}
+
+			/*
+			 * Supervisor restart policy: while clients
+			 * remain, retry with exponential backoff
+			 * (250ms doubling to 8s) instead of giving
+			 * up — a pipeline that fails instantly (e.g.
+			 * syntax error) settles at the cap rather
+			 * than spinning. The verify timer re-enters
+			 * the IDLE path when the backoff expires;
+			 * rapid_fails resets once frames flow again.
+			 */
+			timer_arm(stall_fd, 0, 0);
+			rapid_fails++;
+			stats.restarts++;
+			int remaining = tracker_scan(&trk,
+				watch_devs, n_watch, our_pid, 0);
+			if (remaining > 0) {
+				int shift = rapid_fails - 1;
+				if (shift > 5)
+					shift = 5;
+				int delay = BACKOFF_BASE_MS << shift;
+				if (delay > BACKOFF_MAX_MS)
+					delay = BACKOFF_MAX_MS;
+				backoff_until =
+					(long long)(now_ns() /
+						    1000000) + delay;
+				timer_arm(verify_fd, delay, 0);
+				fprintf(stderr,
+					"[monitor] %d client(s)"
+					" still connected —"
+					" restarting in %dms\n",
+					remaining, delay);
+				printf("RESTART delay_ms=%d"
+				       " fails=%d\n",
+				       delay, rapid_fails);
+				evsock_emit(RELAY_EV_RESTART, remaining,
+					    drop_count, delay);
+			}
 		}
 	}
 
+
 	/* Cleanup */
 	fprintf(stderr, "[monitor] Shutting down\n");
 	if (relay_active)
-		stop_pipeline(child_pid, pipe_fd);
+		pipeline_down(use_embed, child_pid, pipe_fd);
+#ifdef HAVE_IO_URING
+	uring_stop(&urg);
+#endif
+	if (io == IO_MMAP)
+		out_mmap_teardown(fd, &omap);
+	for (int i = 0; i < n_mirrors; i++)
+		if (mirrors[i].fd >= 0)
+			close(mirrors[i].fd);
+	if (use_shm)
+		shm_ring_destroy(&ring);
+	close(heart_fd);
+	close(verify_fd);
+	close(standby_fd);
+	close(stall_fd);
+	close(ep);
+	evsock_cleanup();
+	tracker_close(&trk);
 	free(frame_buf);
+	free(conv_buf);
 	free(black_frame);
 	if (fd >= 0)
 		close(fd);
@@ -3,9 +3,12 @@
 
 import json
 import os
+import socket
+import struct
 import subprocess
 import sys
 import threading
+import time
 
 # Require a display server
 if not os.environ.get("DISPLAY") and not os.environ.get("WAYLAND_DISPLAY"):
@@ -44,12 +47,25 @@ except (ValueError, ImportError):
 
 RELAY_CMD = "/usr/local/bin/camera-relay"
 POLL_INTERVAL = 5  # seconds
+STATS_CACHE = os.path.join(os.environ.get("XDG_RUNTIME_DIR", "/tmp"), "camera-relay-stats")
+
+# Monitor event socket — push updates, no polling or line parsing.
+# One 64-byte struct relay_event per SOCK_SEQPACKET datagram; layout
+# and version must match camera-relay-monitor.c.
+EVENT_SOCK = os.path.join(os.environ.get("XDG_RUNTIME_DIR", "/tmp"), "camera-relay-events")
+RELAY_EVENT_FMT = "<HHIQQQQQIIII"
+RELAY_EVENT_SIZE = struct.calcsize(RELAY_EVENT_FMT)
+RELAY_EVENT_VERSION = 1
+EV_READY, EV_START, EV_STOP, EV_RESTART, EV_STATS = range(5)
 
 
 class CameraRelaySystray:
     def __init__(self):
         self.running = False
         self.persistent = False
+        self.state = "stopped"
+        self.mon_state = None  # monitor state via event socket; None = not subscribed
+        self.mon_stats = {}
 
         if USE_APPINDICATOR:
             self.indicator = AppIndicator3.Indicator.new(
@@ -76,9 +92,13 @@ class CameraRelaySystray:
             self.status_icon.connect("popup-menu", self._on_status_icon_popup)
             self.status_icon.set_visible(True)
 
-        # Initial status check, then poll
+        # Initial status check, then poll. The poll stays for the
+        # CLI-owned fields (running/persistent) and as fallback when
+        # the monitor event socket is unavailable; streaming state and
+        # counters arrive pushed over the socket with no subprocess cost.
         self._poll_status()
         GLib.timeout_add_seconds(POLL_INTERVAL, self._poll_status)
+        threading.Thread(target=self._event_loop, daemon=True).start()
 
     def _build_menu(self):
         menu = Gtk.Menu()
@@ -132,11 +152,78 @@ class CameraRelaySystray:
         except (subprocess.TimeoutExpired, json.JSONDecodeError, FileNotFoundError):
             return {"running": False, "persistent": False, "camera": "", "device": ""}
 
+    def _get_stats(self):
+        """Latest monitor telemetry snapshot (key=value pairs), or {}."""
+        try:
+            with open(STATS_CACHE) as f:
+                return dict(kv.split("=", 1) for kv in f.read().split())
+        except (OSError, ValueError):
+            return {}
+
+    def _event_loop(self):
+        """Subscribe to the monitor's binary event socket.
+
+        Each recv() yields exactly one fixed-size event (SEQPACKET
+        framing), so there is nothing to parse — just unpack and
+        refresh the UI. Reconnects whenever the socket is absent or
+        drops; the 5s status poll covers those gaps.
+        """
+        while True:
+            try:
+                sock = socket.socket(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+                sock.connect(EVENT_SOCK)
+            except OSError:
+                time.sleep(POLL_INTERVAL)
+                continue
+            try:
+                while True:
+                    pkt = sock.recv(RELAY_EVENT_SIZE)
+                    if len(pkt) < RELAY_EVENT_SIZE:
+                        break
+                    (version, etype, clients, _t_ns, frames, _black,
+                     drops, restarts, fps_centi, _p50, _p99,
+                     _delay_ms) = struct.unpack(RELAY_EVENT_FMT, pkt)
+                    if version != RELAY_EVENT_VERSION:
+                        break  # incompatible monitor — poll instead
+                    if etype == EV_START:
+                        self.mon_state = "streaming"
+                    elif etype in (EV_READY, EV_STOP, EV_RESTART):
+                        self.mon_state = "idle"
+                    self.mon_stats = {
+                        "frames": frames,
+                        "drops": drops,
+                        "clients": clients,
+                        "fps": fps_centi / 100.0,
+                        "restarts": restarts,
+                    }
+                    GLib.idle_add(self._on_event)
+            except OSError:
+                pass
+            finally:
+                sock.close()
+            # Monitor gone (or incompatible) — back to poll-driven UI
+            self.mon_state = None
+            self.mon_stats = {}
+            GLib.idle_add(self._on_event)
+            time.sleep(1)
+
+    def _on_event(self):
+        """UI refresh driven by a pushed monitor event (main thread)."""
+        self._update_ui()
+        return False  # one-shot for GLib.idle_add
+
     def _poll_status(self):
         status = self._get_status()
         self.running = status.get("running", False)
         self.persistent = status.get("persistent", False)
         self.state = status.get("state", "stopped")
+        self._update_ui()
+        return True  # keep polling
+
+    def _update_ui(self):
+        # Event-socket state is fresher than the CLI's view when the
+        # relay is up; fall back to the polled state otherwise.
+        state = self.mon_state if (self.running and self.mon_state) else self.state
 
         # Update menu labels
         if hasattr(self, "item_toggle"):
@@ -153,10 +240,23 @@ class CameraRelaySystray:
         if hasattr(self, "item_status"):
             if not self.running:
                 label = "Status: STOPPED"
-            elif self.state == "idle":
+            elif state == "idle":
                 label = "Status: ON-DEMAND (idle)"
-            elif self.state == "streaming":
+            elif state == "streaming":
                 label = "Status: STREAMING"
+                if self.mon_stats:
+                    label += " — %.1f fps, %d frames, %d dropped" % (
+                        self.mon_stats["fps"],
+                        self.mon_stats["frames"],
+                        self.mon_stats["drops"],
+                    )
+                else:
+                    stats = self._get_stats()
+                    if stats.get("frames"):
+                        label += " — %s frames, %s dropped" % (
+                            stats["frames"],
+                            stats.get("drops", "0"),
+                        )
             else:
                 label = "Status: RUNNING"
             if self.persistent:
@@ -164,7 +264,7 @@ class CameraRelaySystray:
             self.item_status.set_label(label)
 
         # Update icon: streaming=active, idle/on-demand=ready, stopped=disabled
-        if self.running and self.state == "streaming":
+        if self.running and state == "streaming":
             icon = "camera-video-symbolic"
         elif self.running:
             icon = "camera-switch-symbolic"  # idle/on-demand
@@ -176,8 +276,6 @@ class CameraRelaySystray:
         else:
             self.status_icon.set_from_icon_name(icon)
 
-        return True  # keep polling
-
     def _on_toggle(self, _widget):
         action = "stop" if self.running else "start"
         # Disable toggle while action is in progress
@@ -16,9 +16,16 @@
  *
  * FIXES:
  * 1. Intercept gst_element_factory_make() and replace the CameraBin
- *    videoconvert elements (vfbin-csp, src-videoconvert) with a bin
- *    that forces a buffer copy through NV12, breaking the dependency
- *    on the source buffer's lifetime.
+ *    videoconvert elements (vfbin-csp, src-videoconvert) with a guarded
+ *    bin that breaks the dependency on the source buffer's lifetime.
+ *    A buffer probe on the bin's sink pad checks each buffer's memory:
+ *    DMABUF-backed buffers already hold their own fd reference (lifetime
+ *    is decoupled from the source's pool), so they pass through
+ *    zero-copy; system-memory buffers are deep-copied into owned memory.
+ *    That replaces the old approach — an unconditional two-stage
+ *    videoconvert round-trip through NV12 — which paid a full-frame
+ *    conversion on every buffer. If the probe symbols are unavailable,
+ *    the NV12 copy bin is kept as the fallback.
  *
  * 2. Intercept pipewiresrc creation and replace with v4l2src pointing
  *    at the camera relay loopback device (/dev/video0). The relay must
@@ -44,6 +51,76 @@ static GstElement* (*real_factory_make)(const char *, const char *);
 static GstElement* (*parse_bin_fn)(const char *, int, void **);
 static void (*g_object_set_fn)(GObject *, const char *, ...);
 
+/* Symbols for the DMABUF-aware copy guard (all libgstreamer core) */
+static void* (*get_static_pad_fn)(void *, const char *);
+static unsigned long (*pad_add_probe_fn)(void *, int, void *, void *,
+                                         void *);
+static unsigned int (*buffer_n_memory_fn)(void *);
+static void* (*buffer_peek_memory_fn)(void *, unsigned int);
+static int (*memory_is_type_fn)(void *, const char *);
+static void* (*buffer_copy_deep_fn)(void *);
+static void (*mini_object_unref_fn)(void *);
+static void (*object_unref_fn)(void *);
+
+/* Mirrors the public GstPadProbeInfo ABI — we only touch .data, but
+ * replacing the buffer requires writing the field directly (there is
+ * no setter in the API). */
+struct probe_info {
+    int type;               /* GstPadProbeType */
+    unsigned long id;       /* gulong */
+    void *data;
+    unsigned long long offset;
+    unsigned int size;
+};
+
+#define PAD_PROBE_TYPE_BUFFER (1 << 4)
+#define PAD_PROBE_OK 1
+
+/* Per-buffer lifetime guard: DMABUF memory carries its own reference
+ * and is safe to hand downstream as-is; anything else gets deep-copied
+ * so downstream never reads recycled pool memory. Memory type can vary
+ * buffer to buffer (renegotiation), so the probe stays installed. */
+static int copy_guard_probe(void *pad, struct probe_info *info,
+                            void *user_data) {
+    void *buf = info->data;
+    unsigned int n = buffer_n_memory_fn(buf);
+    (void)pad; (void)user_data;
+
+    for (unsigned int i = 0; i < n; i++) {
+        if (memory_is_type_fn(buffer_peek_memory_fn(buf, i), "dmabuf"))
+            return PAD_PROBE_OK;    /* zero-copy passthrough */
+    }
+
+    void *copy = buffer_copy_deep_fn(buf);
+    if (copy) {
+        info->data = copy;
+        mini_object_unref_fn(buf);
+    }
+    return PAD_PROBE_OK;
+}
+
+/* Resolve the probe symbols once; 0 if any is missing (old GStreamer
+ * or stripped core lib) — callers then fall back to the NV12 copy bin. */
+static int guard_symbols_ready(void) {
+    static int state = -1;
+    if (state >= 0) return state;
+
+    get_static_pad_fn = dlsym(RTLD_DEFAULT, "gst_element_get_static_pad");
+    pad_add_probe_fn = dlsym(RTLD_DEFAULT, "gst_pad_add_probe");
+    buffer_n_memory_fn = dlsym(RTLD_DEFAULT, "gst_buffer_n_memory");
+    buffer_peek_memory_fn = dlsym(RTLD_DEFAULT, "gst_buffer_peek_memory");
+    memory_is_type_fn = dlsym(RTLD_DEFAULT, "gst_memory_is_type");
+    buffer_copy_deep_fn = dlsym(RTLD_DEFAULT, "gst_buffer_copy_deep");
+    mini_object_unref_fn = dlsym(RTLD_DEFAULT, "gst_mini_object_unref");
+    object_unref_fn = dlsym(RTLD_DEFAULT, "gst_object_unref");
+
+    state = get_static_pad_fn && pad_add_probe_fn &&
+            buffer_n_memory_fn && buffer_peek_memory_fn &&
+            memory_is_type_fn && buffer_copy_deep_fn &&
+            mini_object_unref_fn && object_unref_fn;
+    return state;
+}
+
 /* Thread-local recursion guard: our replacement bins create videoconvert
  * elements internally, so we must not intercept those recursive calls. */
 static __thread int inside_fix = 0;
@@ -92,12 +169,36 @@ GstElement* gst_element_factory_make(const char *factoryname, const char *name)
 
         inside_fix = 1;
 
-        /* Two-stage conversion forces a buffer copy through NV12.
-         * The first videoconvert allocates a new buffer for NV12 output,
-         * so the second converter reads from safe, owned memory. */
-        GstElement *bin = parse_bin_fn(
-            "videoconvert ! video/x-raw,format=NV12 ! videoconvert",
-            1 /* ghost_unlinked_pads */, NULL);
+        GstElement *bin = NULL;
+        if (guard_symbols_ready()) {
+            /* Fast path: single videoconvert with the copy-guard
+             * probe on its sink — DMABUF buffers pass through
+             * zero-copy, system-memory buffers are deep-copied.
+             * No forced NV12 round-trip either way. */
+            bin = parse_bin_fn("videoconvert",
+                1 /* ghost_unlinked_pads */, NULL);
+            if (bin) {
+                void *sinkpad = get_static_pad_fn(bin, "sink");
+                if (sinkpad) {
+                    pad_add_probe_fn(sinkpad, PAD_PROBE_TYPE_BUFFER,
+                                     copy_guard_probe, NULL, NULL);
+                    object_unref_fn(sinkpad);
+                } else {
+                    /* No ghost sink — abandon the fast path */
+                    object_unref_fn(bin);
+                    bin = NULL;
+                }
+            }
+        }
+        if (!bin) {
+            /* Two-stage conversion forces a buffer copy through NV12.
+             * The first videoconvert allocates a new buffer for NV12
+             * output, so the second converter reads from safe, owned
+             * memory. */
+            bin = parse_bin_fn(
+                "videoconvert ! video/x-raw,format=NV12 ! videoconvert",
+                1 /* ghost_unlinked_pads */, NULL);
+        }
 
         inside_fix = 0;
 
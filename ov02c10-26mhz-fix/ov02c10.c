@@ -13,6 +13,7 @@
 #include <linux/module.h>
 #include <linux/pm_runtime.h>
 #include <linux/regmap.h>
+#include <linux/slab.h>
 #include <linux/version.h>
 #include <media/v4l2-cci.h>
 #include <media/v4l2-common.h>
@@ -35,6 +36,9 @@ devm_v4l2_sensor_clk_get(struct device *dev, const char *id)
 #endif
 
 #define OV02C10_LINK_FREQ_400MHZ	400000000ULL
+#define OV02C10_LINK_FREQ_800MHZ	800000000ULL
+#define OV02C10_LINK_FREQ_400MHZ_INDEX	0
+#define OV02C10_LINK_FREQ_800MHZ_INDEX	1
 #define OV02C10_MCLK_19_2MHZ		19200000
 #define OV02C10_MCLK_26MHZ		26000000
 #define OV02C10_RGB_DEPTH		10
@@ -93,6 +97,12 @@ struct ov02c10_mode {
 	/* Min vertical timining size */
 	u32 vts_min;
 
+	/* Nominal frame rate at vts_min */
+	u32 fps;
+
+	/* Index into link_freq_menu_items */
+	u32 link_freq_index;
+
 	/* Sensor register settings for this resolution */
 	const struct reg_sequence *reg_sequence;
 	const int sequence_length;
@@ -351,6 +361,272 @@ static const struct reg_sequence sensor_1928x1092_30fps_2lane_setting[] = {
 	{0x3016, 0x32},
 };
 
+
+/*
+ * 2x2 binned readout of the same capture window. Only the output
+ * size (0x3808-0x380b), the odd-increment/binning controls (0x3814,
+ * 0x3816, 0x3820) and the BLC anchor window (0x4008/0x4009) differ
+ * from the full-resolution table; line and frame timing are kept, so
+ * the full-resolution lane settings apply unchanged.
+ */
+static const struct reg_sequence sensor_964x546_binned_setting[] = {
+	{0x0301, 0x08},
+	{0x0303, 0x06},
+	{0x0304, 0x01},
+	{0x0305, 0xe0},
+	{0x0313, 0x40},
+	{0x031c, 0x4f},
+	{0x3020, 0x97},
+	{0x3022, 0x01},
+	{0x3026, 0xb4},
+	{0x303b, 0x00},
+	{0x303c, 0x4f},
+	{0x303d, 0xe6},
+	{0x303e, 0x00},
+	{0x303f, 0x03},
+	{0x3021, 0x23},
+	{0x3501, 0x04},
+	{0x3502, 0x6c},
+	{0x3504, 0x0c},
+	{0x3507, 0x00},
+	{0x3508, 0x08},
+	{0x3509, 0x00},
+	{0x350a, 0x01},
+	{0x350b, 0x00},
+	{0x350c, 0x41},
+	{0x3600, 0x84},
+	{0x3603, 0x08},
+	{0x3610, 0x57},
+	{0x3611, 0x1b},
+	{0x3613, 0x78},
+	{0x3623, 0x00},
+	{0x3632, 0xa0},
+	{0x3642, 0xe8},
+	{0x364c, 0x70},
+	{0x365f, 0x0f},
+	{0x3708, 0x30},
+	{0x3714, 0x24},
+	{0x3725, 0x02},
+	{0x3737, 0x08},
+	{0x3739, 0x28},
+	{0x3749, 0x32},
+	{0x374a, 0x32},
+	{0x374b, 0x32},
+	{0x374c, 0x32},
+	{0x374d, 0x81},
+	{0x374e, 0x81},
+	{0x374f, 0x81},
+	{0x3752, 0x36},
+	{0x3753, 0x36},
+	{0x3754, 0x36},
+	{0x3761, 0x00},
+	{0x376c, 0x81},
+	{0x3774, 0x18},
+	{0x3776, 0x08},
+	{0x377c, 0x81},
+	{0x377d, 0x81},
+	{0x377e, 0x81},
+	{0x37a0, 0x44},
+	{0x37a6, 0x44},
+	{0x37aa, 0x0d},
+	{0x37ae, 0x00},
+	{0x37cb, 0x03},
+	{0x37cc, 0x01},
+	{0x37d8, 0x02},
+	{0x37d9, 0x10},
+	{0x37e1, 0x10},
+	{0x37e2, 0x18},
+	{0x37e3, 0x08},
+	{0x37e4, 0x08},
+	{0x37e5, 0x02},
+	{0x37e6, 0x08},
+
+	/* 964x546, 2x2 binned from the full array */
+	{0x3800, 0x00},
+	{0x3801, 0x00},
+	{0x3802, 0x00},
+	{0x3803, 0x00},
+	{0x3804, 0x07},
+	{0x3805, 0x8f},
+	{0x3806, 0x04},
+	{0x3807, 0x47},
+	{0x3808, 0x03},
+	{0x3809, 0xc4},
+	{0x380a, 0x02},
+	{0x380b, 0x22},
+	{0x3814, 0x03},
+	{0x3815, 0x01},
+	{0x3816, 0x03},
+	{0x3817, 0x01},
+
+	{0x3820, 0xb2},
+	{0x3821, 0x00},
+	{0x3822, 0x80},
+	{0x3823, 0x08},
+	{0x3824, 0x00},
+	{0x3825, 0x20},
+	{0x3826, 0x00},
+	{0x3827, 0x08},
+	{0x382a, 0x00},
+	{0x382b, 0x08},
+	{0x382d, 0x00},
+	{0x382e, 0x00},
+	{0x382f, 0x23},
+	{0x3834, 0x00},
+	{0x3839, 0x00},
+	{0x383a, 0xd1},
+	{0x383e, 0x03},
+	{0x393d, 0x29},
+	{0x393f, 0x6e},
+	{0x394b, 0x06},
+	{0x394c, 0x06},
+	{0x394d, 0x08},
+	{0x394f, 0x01},
+	{0x3950, 0x01},
+	{0x3951, 0x01},
+	{0x3952, 0x01},
+	{0x3953, 0x01},
+	{0x3954, 0x01},
+	{0x3955, 0x01},
+	{0x3956, 0x01},
+	{0x3957, 0x0e},
+	{0x3958, 0x08},
+	{0x3959, 0x08},
+	{0x395a, 0x08},
+	{0x395b, 0x13},
+	{0x395c, 0x09},
+	{0x395d, 0x05},
+	{0x395e, 0x02},
+	{0x395f, 0x00},
+	{0x395f, 0x00},
+	{0x3960, 0x00},
+	{0x3961, 0x00},
+	{0x3962, 0x00},
+	{0x3963, 0x00},
+	{0x3964, 0x00},
+	{0x3965, 0x00},
+	{0x3966, 0x00},
+	{0x3967, 0x00},
+	{0x3968, 0x01},
+	{0x3969, 0x01},
+	{0x396a, 0x01},
+	{0x396b, 0x01},
+	{0x396c, 0x10},
+	{0x396d, 0xf0},
+	{0x396e, 0x11},
+	{0x396f, 0x00},
+	{0x3970, 0x37},
+	{0x3971, 0x37},
+	{0x3972, 0x37},
+	{0x3973, 0x37},
+	{0x3974, 0x00},
+	{0x3975, 0x3c},
+	{0x3976, 0x3c},
+	{0x3977, 0x3c},
+	{0x3978, 0x3c},
+	{0x3c00, 0x0f},
+	{0x3c20, 0x01},
+	{0x3c21, 0x08},
+	{0x3f00, 0x8b},
+	{0x3f02, 0x0f},
+	{0x4000, 0xc3},
+	{0x4001, 0xe0},
+	{0x4002, 0x00},
+	{0x4003, 0x40},
+	{0x4008, 0x02},
+	{0x4009, 0x11},
+	{0x400a, 0x04},
+	{0x400b, 0x01},
+	{0x4077, 0x06},
+	{0x4078, 0x00},
+	{0x4079, 0x1a},
+	{0x407a, 0x7f},
+	{0x407b, 0x01},
+	{0x4080, 0x03},
+	{0x4081, 0x84},
+	{0x4308, 0x03},
+	{0x4309, 0xff},
+	{0x430d, 0x00},
+	{0x4806, 0x00},
+	{0x4813, 0x00},
+	{0x4837, 0x10},
+	{0x4857, 0x05},
+	{0x4500, 0x07},
+	{0x4501, 0x00},
+	{0x4503, 0x00},
+	{0x450a, 0x04},
+	{0x450e, 0x00},
+	{0x450f, 0x00},
+	{0x4900, 0x00},
+	{0x4901, 0x00},
+	{0x4902, 0x01},
+	{0x5001, 0x50},
+	{0x5006, 0x00},
+	{0x5080, 0x40},
+	{0x5181, 0x2b},
+	{0x5202, 0xa3},
+	{0x5206, 0x01},
+	{0x5207, 0x00},
+	{0x520a, 0x01},
+	{0x520b, 0x00},
+	{0x365d, 0x00},
+	{0x4815, 0x40},
+	{0x4816, 0x12},
+	{0x4f00, 0x01},
+};
+
+/*
+ * 60 fps lane settings: identical readout and VTS/HTS to the 30 fps
+ * tables, with the MIPI PLL divider halved for a 800 Mbps/lane link
+ * and the global timing (0x4837) adjusted to match. Twice the pixel
+ * rate over the same frame timing doubles the frame rate.
+ */
+static const struct reg_sequence sensor_1928x1092_60fps_1lane_setting[] = {
+	{0x301b, 0xd2},
+	{0x3027, 0xe1},
+	{0x380c, 0x08},
+	{0x380d, 0xe8},
+	{0x380e, 0x04},
+	{0x380f, 0x8c},
+	{0x394e, 0x0b},
+	{0x4800, 0x24},
+	{0x5000, 0xf5},
+	/* plls */
+	{0x0303, 0x02},
+	{0x0305, 0x90},
+	{0x0316, 0x90},
+	{0x3016, 0x12},
+	{0x4837, 0x08},
+};
+
+static const struct reg_sequence sensor_1928x1092_60fps_2lane_setting[] = {
+	{0x301b, 0xf0},
+	{0x3027, 0xf1},
+	{0x380c, 0x04},
+	{0x380d, 0x74},
+	{0x380e, 0x09},
+	{0x380f, 0x18},
+	{0x394e, 0x0a},
+	{0x4041, 0x20},
+	{0x4884, 0x04},
+	{0x4800, 0x64},
+	{0x4d00, 0x03},
+	{0x4d01, 0xd8},
+	{0x4d02, 0xba},
+	{0x4d03, 0xa0},
+	{0x4d04, 0xb7},
+	{0x4d05, 0x34},
+	{0x4d0d, 0x00},
+	{0x5000, 0xfd},
+	{0x481f, 0x30},
+	/* plls */
+	{0x0303, 0x02},
+	{0x0305, 0x90},
+	{0x0316, 0x90},
+	{0x3016, 0x32},
+	{0x4837, 0x08},
+};
+
 static const char * const ov02c10_test_pattern_menu[] = {
 	"Disabled",
 	"Color Bar",
@@ -360,7 +636,8 @@ static const char * const ov02c10_test_pattern_menu[] = {
 };
 
 static const s64 link_freq_menu_items[] = {
-	OV02C10_LINK_FREQ_400MHZ,
+	[OV02C10_LINK_FREQ_400MHZ_INDEX] = OV02C10_LINK_FREQ_400MHZ,
+	[OV02C10_LINK_FREQ_800MHZ_INDEX] = OV02C10_LINK_FREQ_800MHZ,
 };
 
 static const struct ov02c10_mode supported_modes[] = {
@@ -369,6 +646,8 @@ static const struct ov02c10_mode supported_modes[] = {
 		.height = 1092,
 		.hts = 2280,
 		.vts_min = 1164,
+		.fps = 30,
+		.link_freq_index = OV02C10_LINK_FREQ_400MHZ_INDEX,
 		.reg_sequence = sensor_1928x1092_30fps_setting,
 		.sequence_length = ARRAY_SIZE(sensor_1928x1092_30fps_setting),
 		.lane_settings = {
@@ -380,8 +659,346 @@ static const struct ov02c10_mode supported_modes[] = {
 			ARRAY_SIZE(sensor_1928x1092_30fps_2lane_setting),
 		},
 	},
+	{
+		/* Same readout as 1080p30 at twice the link rate */
+		.width = 1928,
+		.height = 1092,
+		.hts = 2280,
+		.vts_min = 1164,
+		.fps = 60,
+		.link_freq_index = OV02C10_LINK_FREQ_800MHZ_INDEX,
+		.reg_sequence = sensor_1928x1092_30fps_setting,
+		.sequence_length = ARRAY_SIZE(sensor_1928x1092_30fps_setting),
+		.lane_settings = {
+			sensor_1928x1092_60fps_1lane_setting,
+			sensor_1928x1092_60fps_2lane_setting
+		},
+		.lane_settings_length = {
+			ARRAY_SIZE(sensor_1928x1092_60fps_1lane_setting),
+			ARRAY_SIZE(sensor_1928x1092_60fps_2lane_setting),
+		},
+	},
+	{
+		/* 2x2 binned: quarter the CSI-2 payload, same timing */
+		.width = 964,
+		.height = 546,
+		.hts = 2280,
+		.vts_min = 1164,
+		.fps = 30,
+		.link_freq_index = OV02C10_LINK_FREQ_400MHZ_INDEX,
+		.reg_sequence = sensor_964x546_binned_setting,
+		.sequence_length = ARRAY_SIZE(sensor_964x546_binned_setting),
+		.lane_settings = {
+			sensor_1928x1092_30fps_1lane_setting,
+			sensor_1928x1092_30fps_2lane_setting
+		},
+		.lane_settings_length = {
+			ARRAY_SIZE(sensor_1928x1092_30fps_1lane_setting),
+			ARRAY_SIZE(sensor_1928x1092_30fps_2lane_setting),
+		},
+	},
+};
+
+/*
+ * Burst programming of the mode tables. The reg_sequence tables are
+ * static, so runs of consecutive registers are coalesced once at
+ * module init into auto-increment multi-byte transfers; applying a
+ * mode then takes a handful of I2C transactions instead of ~200
+ * single-register writes, which is most of the time-to-first-frame.
+ * Only entries adjacent in the table are merged, so write order is
+ * preserved (the PLL writes at the end of the lane tables stay last).
+ */
+struct ov02c10_reg_run {
+	u16 addr;	/* first register of the run */
+	u16 len;	/* consecutive registers in the run */
+	const u8 *vals;
+};
+
+struct ov02c10_burst_table {
+	const struct reg_sequence *seq;	/* source table */
+	struct ov02c10_reg_run *runs;
+	u8 *vals;
+	int num_runs;
+};
+
+/* One slot per mode table and lane table, deduplicated by pointer */
+static struct ov02c10_burst_table ov02c10_burst_tables[3 * ARRAY_SIZE(supported_modes)];
+static int ov02c10_num_burst_tables;
+
+static int ov02c10_build_burst_table(struct ov02c10_burst_table *bt,
+				     const struct reg_sequence *seq, int len)
+{
+	int i, run = -1;
+
+	bt->runs = kcalloc(len, sizeof(*bt->runs), GFP_KERNEL);
+	bt->vals = kmalloc(len, GFP_KERNEL);
+	if (!bt->runs || !bt->vals) {
+		kfree(bt->runs);
+		kfree(bt->vals);
+		bt->runs = NULL;
+		bt->vals = NULL;
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < len; i++) {
+		bt->vals[i] = seq[i].def;
+		if (run >= 0 &&
+		    seq[i].reg == bt->runs[run].addr + bt->runs[run].len) {
+			bt->runs[run].len++;
+			continue;
+		}
+		run++;
+		bt->runs[run].addr = seq[i].reg;
+		bt->runs[run].len = 1;
+		bt->runs[run].vals = &bt->vals[i];
+	}
+
+	bt->seq = seq;
+	bt->num_runs = run + 1;
+	return 0;
+}
+
+static void ov02c10_free_burst_tables(void)
+{
+	int i;
+
+	for (i = 0; i < ov02c10_num_burst_tables; i++) {
+		kfree(ov02c10_burst_tables[i].runs);
+		kfree(ov02c10_burst_tables[i].vals);
+	}
+	ov02c10_num_burst_tables = 0;
+}
+
+static const struct ov02c10_burst_table *
+ov02c10_find_burst_table(const struct reg_sequence *seq)
+{
+	int i;
+
+	for (i = 0; i < ov02c10_num_burst_tables; i++)
+		if (ov02c10_burst_tables[i].seq == seq)
+			return &ov02c10_burst_tables[i];
+
+	return NULL;
+}
+
+static int ov02c10_init_burst_tables(void)
+{
+	unsigned int i, j;
+	int ret;
+
+	for (i = 0; i < ARRAY_SIZE(supported_modes); i++) {
+		const struct ov02c10_mode *mode = &supported_modes[i];
+		const struct reg_sequence *seqs[3] = {
+			mode->reg_sequence,
+			mode->lane_settings[0],
+			mode->lane_settings[1],
+		};
+		const int lens[3] = {
+			mode->sequence_length,
+			mode->lane_settings_length[0],
+			mode->lane_settings_length[1],
+		};
+
+		for (j = 0; j < ARRAY_SIZE(seqs); j++) {
+			if (ov02c10_find_burst_table(seqs[j]))
+				continue;
+			ret = ov02c10_build_burst_table(
+				&ov02c10_burst_tables[ov02c10_num_burst_tables],
+				seqs[j], lens[j]);
+			if (ret) {
+				ov02c10_free_burst_tables();
+				return ret;
+			}
+			ov02c10_num_burst_tables++;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Apply a register sequence, as coalesced bursts when a precomputed
+ * table exists, falling back to single writes otherwise (or when the
+ * adapter rejects a multi-byte transfer).
+ */
+static int ov02c10_write_sequence(struct ov02c10 *ov02c10,
+				  const struct reg_sequence *seq, int len)
+{
+	const struct ov02c10_burst_table *bt = ov02c10_find_burst_table(seq);
+	int i, ret;
+
+	if (!bt)
+		return regmap_multi_reg_write(ov02c10->regmap, seq, len);
+
+	for (i = 0; i < bt->num_runs; i++) {
+		const struct ov02c10_reg_run *run = &bt->runs[i];
+
+		if (run->len == 1)
+			ret = regmap_write(ov02c10->regmap, run->addr,
+					   run->vals[0]);
+		else
+			ret = regmap_raw_write(ov02c10->regmap, run->addr,
+					       run->vals, run->len);
+		if (ret) {
+			dev_warn(ov02c10->dev,
+				 "burst write at 0x%04x failed (%d), using single writes\n",
+				 run->addr, ret);
+			return regmap_multi_reg_write(ov02c10->regmap, seq,
+						      len);
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Pairwise mode deltas. Switching modes replays a full table even
+ * though most of it is identical between modes; since the tables are
+ * static, the changed registers for every (from, to) pair are
+ * computed once and a switch programs only those. Each delta is kept
+ * per lane configuration because the lane tables differ too.
+ */
+struct ov02c10_mode_delta {
+	const struct ov02c10_mode *from;
+	const struct ov02c10_mode *to;
+	struct reg_sequence *seq[2];	/* per lane config */
+	int len[2];
 };
 
+static struct ov02c10_mode_delta ov02c10_mode_deltas[ARRAY_SIZE(supported_modes) *
+						    (ARRAY_SIZE(supported_modes) - 1)];
+static int ov02c10_num_mode_deltas;
+
+/* Final value a (base + lane) sequence leaves in reg, -1 if untouched */
+static int ov02c10_seq_final_value(const struct ov02c10_mode *mode, int lane,
+				   unsigned int reg)
+{
+	int i, val = -1;
+
+	for (i = 0; i < mode->sequence_length; i++)
+		if (mode->reg_sequence[i].reg == reg)
+			val = mode->reg_sequence[i].def;
+	for (i = 0; i < mode->lane_settings_length[lane]; i++)
+		if (mode->lane_settings[lane][i].reg == reg)
+			val = mode->lane_settings[lane][i].def;
+
+	return val;
+}
+
+/*
+ * Value reg holds after the first n delta entries have been applied,
+ * falling back to the from-mode's final value when the delta has not
+ * touched it yet.
+ */
+static int ov02c10_delta_cur_value(const struct reg_sequence *seq, int n,
+				   const struct ov02c10_mode *from, int lane,
+				   unsigned int reg)
+{
+	int i;
+
+	for (i = n - 1; i >= 0; i--)
+		if (seq[i].reg == reg)
+			return seq[i].def;
+
+	return ov02c10_seq_final_value(from, lane, reg);
+}
+
+static int ov02c10_build_mode_delta(struct ov02c10_mode_delta *d,
+				    const struct ov02c10_mode *from,
+				    const struct ov02c10_mode *to)
+{
+	int lane, i, n;
+
+	for (lane = 0; lane < 2; lane++) {
+		int to_len = to->sequence_length +
+			     to->lane_settings_length[lane];
+		struct reg_sequence *seq;
+
+		seq = kcalloc(to_len, sizeof(*seq), GFP_KERNEL);
+		if (!seq) {
+			if (lane) {
+				kfree(d->seq[0]);
+				d->seq[0] = NULL;
+			}
+			return -ENOMEM;
+		}
+
+		n = 0;
+		for (i = 0; i < to_len; i++) {
+			const struct reg_sequence *e =
+				i < to->sequence_length ?
+				&to->reg_sequence[i] :
+				&to->lane_settings[lane][i - to->sequence_length];
+
+			/*
+			 * Filter against the running register state, not
+			 * just the from-mode's finals: the PLL registers
+			 * are written twice (mode table, then lane
+			 * table), and once an intermediate write has been
+			 * kept, the restoring write must be kept too even
+			 * when it matches the from-mode's final value.
+			 */
+			if (ov02c10_delta_cur_value(seq, n, from, lane,
+						    e->reg) != (int)e->def)
+				seq[n++] = *e;
+		}
+		d->seq[lane] = seq;
+		d->len[lane] = n;
+	}
+
+	d->from = from;
+	d->to = to;
+	return 0;
+}
+
+static void ov02c10_free_mode_deltas(void)
+{
+	int i;
+
+	for (i = 0; i < ov02c10_num_mode_deltas; i++) {
+		kfree(ov02c10_mode_deltas[i].seq[0]);
+		kfree(ov02c10_mode_deltas[i].seq[1]);
+	}
+	ov02c10_num_mode_deltas = 0;
+}
+
+static int ov02c10_init_mode_deltas(void)
+{
+	unsigned int i, j;
+	int ret;
+
+	for (i = 0; i < ARRAY_SIZE(supported_modes); i++) {
+		for (j = 0; j < ARRAY_SIZE(supported_modes); j++) {
+			if (i == j)
+				continue;
+			ret = ov02c10_build_mode_delta(
+				&ov02c10_mode_deltas[ov02c10_num_mode_deltas],
+				&supported_modes[i], &supported_modes[j]);
+			if (ret) {
+				ov02c10_free_mode_deltas();
+				return ret;
+			}
+			ov02c10_num_mode_deltas++;
+		}
+	}
+
+	return 0;
+}
+
+static const struct ov02c10_mode_delta *
+ov02c10_find_mode_delta(const struct ov02c10_mode *from,
+			const struct ov02c10_mode *to)
+{
+	int i;
+
+	for (i = 0; i < ov02c10_num_mode_deltas; i++)
+		if (ov02c10_mode_deltas[i].from == from &&
+		    ov02c10_mode_deltas[i].to == to)
+			return &ov02c10_mode_deltas[i];
+
+	return NULL;
+}
+
 static const char * const ov02c10_supply_names[] = {
 	"dovdd",	/* Digital I/O power */
 	"avdd",		/* Analog power */
@@ -408,8 +1025,15 @@ struct ov02c10 {
 	struct regulator_bulk_data supplies[ARRAY_SIZE(ov02c10_supply_names)];
 
 	/* MIPI lane info */
-	u32 link_freq_index;
+	unsigned long link_freq_bitmap;
 	u8 mipi_lanes;
+
+	/* Currently selected mode */
+	const struct ov02c10_mode *cur_mode;
+
+	/* Shadow of what the sensor was last programmed with */
+	const struct ov02c10_mode *last_mode;
+	bool power_cycled;	/* power_on ran since last programming */
 };
 
 static inline struct ov02c10 *to_ov02c10(struct v4l2_subdev *subdev)
@@ -436,7 +1060,7 @@ static int ov02c10_set_ctrl(struct v4l2_ctrl *ctrl)
 {
 	struct ov02c10 *ov02c10 = container_of(ctrl->handler,
 					     struct ov02c10, ctrl_handler);
-	const u32 height = supported_modes[0].height;
+	const u32 height = ov02c10->cur_mode->height;
 	s64 exposure_max;
 	int ret = 0;
 
@@ -507,13 +1131,72 @@ static const struct v4l2_ctrl_ops ov02c10_ctrl_ops = {
 	.s_ctrl = ov02c10_set_ctrl,
 };
 
+/*
+ * Pick the mode closest to the requested size whose link frequency
+ * the platform offers; among same-size modes the one closest to the
+ * requested frame rate wins.
+ */
+static const struct ov02c10_mode *ov02c10_find_mode(struct ov02c10 *ov02c10,
+						    u32 width, u32 height,
+						    u32 fps)
+{
+	const struct ov02c10_mode *best = NULL;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(supported_modes); i++) {
+		const struct ov02c10_mode *mode = &supported_modes[i];
+
+		if (!(ov02c10->link_freq_bitmap & BIT(mode->link_freq_index)))
+			continue;
+		if (!best) {
+			best = mode;
+			continue;
+		}
+		if (abs_diff(mode->width * mode->height, width * height) <
+		    abs_diff(best->width * best->height, width * height)) {
+			best = mode;
+			continue;
+		}
+		if (mode->width == best->width &&
+		    mode->height == best->height &&
+		    abs_diff(mode->fps, fps) < abs_diff(best->fps, fps))
+			best = mode;
+	}
+
+	return best;
+}
+
+/* Refresh the mode-dependent control limits after a mode change */
+static void ov02c10_update_mode_ctrls(struct ov02c10 *ov02c10)
+{
+	const struct ov02c10_mode *mode = ov02c10->cur_mode;
+	s64 pixel_rate;
+	s32 vblank_def, h_blank;
+
+	/* MIPI lanes are DDR -> use link-freq * 2 */
+	pixel_rate = div_u64(link_freq_menu_items[mode->link_freq_index] *
+			     2 * ov02c10->mipi_lanes, OV02C10_RGB_DEPTH);
+
+	__v4l2_ctrl_s_ctrl(ov02c10->link_freq, mode->link_freq_index);
+	__v4l2_ctrl_modify_range(ov02c10->pixel_rate, 0, pixel_rate, 1,
+				 pixel_rate);
+
+	vblank_def = mode->vts_min * ov02c10->mipi_lanes - mode->height;
+	__v4l2_ctrl_modify_range(ov02c10->vblank, mode->vts_min - mode->height,
+				 OV02C10_VTS_MAX - mode->height, 1, vblank_def);
+	__v4l2_ctrl_s_ctrl(ov02c10->vblank, vblank_def);
+
+	h_blank = mode->hts - mode->width;
+	__v4l2_ctrl_modify_range(ov02c10->hblank, h_blank, h_blank, 1, h_blank);
+}
+
 static int ov02c10_init_controls(struct ov02c10 *ov02c10)
 {
 	struct v4l2_ctrl_handler *ctrl_hdlr = &ov02c10->ctrl_handler;
-	const struct ov02c10_mode *mode = &supported_modes[0];
+	const struct ov02c10_mode *mode = ov02c10->cur_mode;
 	u32 vblank_min, vblank_max, vblank_default, vts_def;
 	struct v4l2_fwnode_device_properties props;
-	s64 exposure_max, h_blank, pixel_rate;
+	s64 exposure_max, h_blank, pixel_rate, pixel_rate_max;
 	int ret;
 
 	v4l2_ctrl_handler_init(ctrl_hdlr, 12);
@@ -521,18 +1204,21 @@ static int ov02c10_init_controls(struct ov02c10 *ov02c10)
 	ov02c10->link_freq = v4l2_ctrl_new_int_menu(ctrl_hdlr,
 						    &ov02c10_ctrl_ops,
 						    V4L2_CID_LINK_FREQ,
-						    ov02c10->link_freq_index, 0,
+						    ARRAY_SIZE(link_freq_menu_items) - 1,
+						    mode->link_freq_index,
 						    link_freq_menu_items);
 	if (ov02c10->link_freq)
 		ov02c10->link_freq->flags |= V4L2_CTRL_FLAG_READ_ONLY;
 
 	/* MIPI lanes are DDR -> use link-freq * 2 */
-	pixel_rate = div_u64(link_freq_menu_items[ov02c10->link_freq_index] *
+	pixel_rate = div_u64(link_freq_menu_items[mode->link_freq_index] *
 			     2 * ov02c10->mipi_lanes, OV02C10_RGB_DEPTH);
+	pixel_rate_max = div_u64(OV02C10_LINK_FREQ_800MHZ *
+				 2 * ov02c10->mipi_lanes, OV02C10_RGB_DEPTH);
 
 	ov02c10->pixel_rate = v4l2_ctrl_new_std(ctrl_hdlr, &ov02c10_ctrl_ops,
 						V4L2_CID_PIXEL_RATE, 0,
-						pixel_rate, 1, pixel_rate);
+						pixel_rate_max, 1, pixel_rate);
 
 	vts_def = mode->vts_min * ov02c10->mipi_lanes;
 
@@ -598,35 +1284,78 @@ static void ov02c10_update_pad_format(const struct ov02c10_mode *mode,
 	fmt->field = V4L2_FIELD_NONE;
 }
 
+/*
+ * Check whether the last-programmed configuration survived a power
+ * cycle by reading back the final register of the lane table (its
+ * value is distinctive per mode and lane count, so a reset or a
+ * partial program fails the check too).
+ */
+static bool ov02c10_state_survived(struct ov02c10 *ov02c10)
+{
+	const struct ov02c10_mode *mode = ov02c10->last_mode;
+	const struct reg_sequence *lane;
+	u64 val;
+
+	if (!mode)
+		return false;
+
+	lane = mode->lane_settings[ov02c10->mipi_lanes - 1];
+	lane += mode->lane_settings_length[ov02c10->mipi_lanes - 1] - 1;
+
+	if (cci_read(ov02c10->regmap, CCI_REG8(lane->reg), &val, NULL))
+		return false;
+
+	return val == lane->def;
+}
+
 static int ov02c10_enable_streams(struct v4l2_subdev *sd,
 				  struct v4l2_subdev_state *state,
 				  u32 pad, u64 streams_mask)
 {
-	const struct ov02c10_mode *mode = &supported_modes[0];
 	struct ov02c10 *ov02c10 = to_ov02c10(sd);
-	const struct reg_sequence *reg_sequence;
-	int ret, sequence_length;
+	const struct ov02c10_mode *mode = ov02c10->cur_mode;
+	int lane, ret;
 
 	ret = pm_runtime_resume_and_get(ov02c10->dev);
 	if (ret)
 		return ret;
 
-	reg_sequence = mode->reg_sequence;
-	sequence_length = mode->sequence_length;
-	ret = regmap_multi_reg_write(ov02c10->regmap,
-				     reg_sequence, sequence_length);
-	if (ret) {
-		dev_err(ov02c10->dev, "failed to set mode\n");
-		goto out;
+	/*
+	 * A power cycle with a wired reset line always clears the
+	 * sensor; without one the supplies are usually board-managed
+	 * and state survives, which a sentinel readback confirms.
+	 */
+	if (ov02c10->power_cycled) {
+		if (ov02c10->reset || !ov02c10_state_survived(ov02c10))
+			ov02c10->last_mode = NULL;
+		ov02c10->power_cycled = false;
 	}
 
-	reg_sequence = mode->lane_settings[ov02c10->mipi_lanes - 1];
-	sequence_length = mode->lane_settings_length[ov02c10->mipi_lanes - 1];
-	ret = regmap_multi_reg_write(ov02c10->regmap,
-				     reg_sequence, sequence_length);
-	if (ret) {
-		dev_err(ov02c10->dev, "failed to write lane settings\n");
-		goto out;
+	lane = ov02c10->mipi_lanes - 1;
+	if (ov02c10->last_mode != mode) {
+		const struct ov02c10_mode_delta *delta = NULL;
+
+		if (ov02c10->last_mode)
+			delta = ov02c10_find_mode_delta(ov02c10->last_mode,
+							mode);
+		if (delta)
+			ret = regmap_multi_reg_write(ov02c10->regmap,
+						     delta->seq[lane],
+						     delta->len[lane]);
+		else
+			ret = ov02c10_write_sequence(ov02c10,
+						     mode->reg_sequence,
+						     mode->sequence_length);
+		if (!ret && !delta)
+			ret = ov02c10_write_sequence(ov02c10,
+					mode->lane_settings[lane],
+					mode->lane_settings_length[lane]);
+		if (ret) {
+			ov02c10->last_mode = NULL;
+			dev_err(ov02c10->dev, "failed to set mode\n");
+			goto out;
+		}
+		ov02c10->last_mode = mode;
 	}
 
 	ret = __v4l2_ctrl_handler_setup(ov02c10->sd.ctrl_handler);
@@ -714,6 +1443,8 @@ static int ov02c10_power_on(struct device *dev)
 		usleep_range(5000, 5100);
 	}
 
+	ov02c10->power_cycled = true;
+
 	return 0;
 }
 
@@ -721,23 +1452,21 @@ static int ov02c10_set_format(struct v4l2_subdev *sd,
 			      struct v4l2_subdev_state *sd_state,
 			      struct v4l2_subdev_format *fmt)
 {
-	const struct ov02c10_mode *mode = &supported_modes[0];
 	struct ov02c10 *ov02c10 = to_ov02c10(sd);
-	s32 vblank_def, h_blank;
+	const struct ov02c10_mode *mode;
 
+	mode = ov02c10_find_mode(ov02c10, fmt->format.width,
+				 fmt->format.height, ov02c10->cur_mode->fps);
 	ov02c10_update_pad_format(mode, &fmt->format);
 	*v4l2_subdev_state_get_format(sd_state, fmt->pad) = fmt->format;
 
 	if (fmt->which == V4L2_SUBDEV_FORMAT_TRY)
 		return 0;
 
+	ov02c10->cur_mode = mode;
+
 	/* Update limits and set FPS to default */
-	vblank_def = mode->vts_min * ov02c10->mipi_lanes - mode->height;
-	__v4l2_ctrl_modify_range(ov02c10->vblank, mode->vts_min - mode->height,
-				 OV02C10_VTS_MAX - mode->height, 1, vblank_def);
-	__v4l2_ctrl_s_ctrl(ov02c10->vblank, vblank_def);
-	h_blank = mode->hts - mode->width;
-	__v4l2_ctrl_modify_range(ov02c10->hblank, h_blank, h_blank, 1, h_blank);
+	ov02c10_update_mode_ctrls(ov02c10);
 
 	return 0;
 }
@@ -758,16 +1487,97 @@ static int ov02c10_enum_frame_size(struct v4l2_subdev *sd,
 				   struct v4l2_subdev_state *sd_state,
 				   struct v4l2_subdev_frame_size_enum *fse)
 {
-	if (fse->index >= ARRAY_SIZE(supported_modes))
-		return -EINVAL;
+	struct ov02c10 *ov02c10 = to_ov02c10(sd);
+	unsigned int i, j, index = 0;
 
 	if (fse->code != MEDIA_BUS_FMT_SGRBG10_1X10)
 		return -EINVAL;
 
-	fse->min_width = supported_modes[fse->index].width;
-	fse->max_width = fse->min_width;
-	fse->min_height = supported_modes[fse->index].height;
-	fse->max_height = fse->min_height;
+	for (i = 0; i < ARRAY_SIZE(supported_modes); i++) {
+		const struct ov02c10_mode *mode = &supported_modes[i];
+
+		if (!(ov02c10->link_freq_bitmap & BIT(mode->link_freq_index)))
+			continue;
+		/* Frame-rate variants share one size entry */
+		for (j = 0; j < i; j++)
+			if (supported_modes[j].width == mode->width &&
+			    supported_modes[j].height == mode->height)
+				break;
+		if (j < i)
+			continue;
+		if (index++ == fse->index) {
+			fse->min_width = mode->width;
+			fse->max_width = mode->width;
+			fse->min_height = mode->height;
+			fse->max_height = mode->height;
+			return 0;
+		}
+	}
+
+	return -EINVAL;
+}
+
+static int ov02c10_enum_frame_interval(struct v4l2_subdev *sd,
+				       struct v4l2_subdev_state *sd_state,
+				       struct v4l2_subdev_frame_interval_enum *fie)
+{
+	struct ov02c10 *ov02c10 = to_ov02c10(sd);
+	unsigned int i, index = 0;
+
+	if (fie->code != MEDIA_BUS_FMT_SGRBG10_1X10)
+		return -EINVAL;
+
+	for (i = 0; i < ARRAY_SIZE(supported_modes); i++) {
+		const struct ov02c10_mode *mode = &supported_modes[i];
+
+		if (mode->width != fie->width || mode->height != fie->height)
+			continue;
+		if (!(ov02c10->link_freq_bitmap & BIT(mode->link_freq_index)))
+			continue;
+		if (index++ == fie->index) {
+			fie->interval.numerator = 1;
+			fie->interval.denominator = mode->fps;
+			return 0;
+		}
+	}
+
+	return -EINVAL;
+}
+
+static int ov02c10_get_frame_interval(struct v4l2_subdev *sd,
+				      struct v4l2_subdev_state *sd_state,
+				      struct v4l2_subdev_frame_interval *fi)
+{
+	struct ov02c10 *ov02c10 = to_ov02c10(sd);
+
+	fi->interval.numerator = 1;
+	fi->interval.denominator = ov02c10->cur_mode->fps;
+
+	return 0;
+}
+
+static int ov02c10_set_frame_interval(struct v4l2_subdev *sd,
+				      struct v4l2_subdev_state *sd_state,
+				      struct v4l2_subdev_frame_interval *fi)
+{
+	struct ov02c10 *ov02c10 = to_ov02c10(sd);
+	const struct v4l2_mbus_framefmt *fmt =
+		v4l2_subdev_state_get_format(sd_state, fi->pad);
+	const struct ov02c10_mode *mode;
+	u32 fps = supported_modes[0].fps;
+
+	if (fi->interval.numerator)
+		fps = DIV_ROUND_CLOSEST(fi->interval.denominator,
+					fi->interval.numerator);
+
+	mode = ov02c10_find_mode(ov02c10, fmt->width, fmt->height, fps);
+	if (fi->which == V4L2_SUBDEV_FORMAT_ACTIVE) {
+		ov02c10->cur_mode = mode;
+		ov02c10_update_mode_ctrls(ov02c10);
+	}
+
+	fi->interval.numerator = 1;
+	fi->interval.denominator = mode->fps;
 
 	return 0;
 }
@@ -790,6 +1600,9 @@ static const struct v4l2_subdev_pad_ops ov02c10_pad_ops = {
 	.get_fmt = v4l2_subdev_get_fmt,
 	.enum_mbus_code = ov02c10_enum_mbus_code,
 	.enum_frame_size = ov02c10_enum_frame_size,
+	.enum_frame_interval = ov02c10_enum_frame_interval,
+	.get_frame_interval = ov02c10_get_frame_interval,
+	.set_frame_interval = ov02c10_set_frame_interval,
 	.enable_streams = ov02c10_enable_streams,
 	.disable_streams = ov02c10_disable_streams,
 };
@@ -857,8 +1670,12 @@ static int ov02c10_check_hwcfg(struct ov02c10 *ov02c10)
 	if (ret)
 		goto check_hwcfg_error;
 
-	/* v4l2_link_freq_to_bitmap() guarantees at least 1 bit is set */
-	ov02c10->link_freq_index = ffs(link_freq_bitmap) - 1;
+	/*
+	 * v4l2_link_freq_to_bitmap() guarantees at least 1 bit is set;
+	 * modes whose link frequency the platform does not offer are
+	 * filtered out of enumeration and selection.
+	 */
+	ov02c10->link_freq_bitmap = link_freq_bitmap;
 
 	if (bus_cfg.bus.mipi_csi2.num_data_lanes != 1 &&
 	    bus_cfg.bus.mipi_csi2.num_data_lanes != 2) {
@@ -921,6 +1738,14 @@ static int ov02c10_probe(struct i2c_client *client)
 	if (ret)
 		return ret;
 
+	ov02c10->cur_mode = ov02c10_find_mode(ov02c10,
+					      supported_modes[0].width,
+					      supported_modes[0].height,
+					      supported_modes[0].fps);
+	if (!ov02c10->cur_mode)
+		return dev_err_probe(ov02c10->dev, -EINVAL,
+				     "no mode matches the platform link frequencies\n");
+
 	ret = ov02c10_get_pm_resources(ov02c10->dev);
 	if (ret)
 		return ret;
@@ -1024,7 +1849,40 @@ static struct i2c_driver ov02c10_i2c_driver = {
 	.remove = ov02c10_remove,
 };
 
-module_i2c_driver(ov02c10_i2c_driver);
+static int __init ov02c10_driver_init(void)
+{
+	int ret;
+
+	/* The mode tables never change: coalesce and diff them once */
+	ret = ov02c10_init_burst_tables();
+	if (ret)
+		return ret;
+
+	ret = ov02c10_init_mode_deltas();
+	if (ret)
+		goto free_burst;
+
+	ret = i2c_add_driver(&ov02c10_i2c_driver);
+	if (ret)
+		goto free_deltas;
+
+	return 0;
+
+free_deltas:
+	ov02c10_free_mode_deltas();
+free_burst:
+	ov02c10_free_burst_tables();
+	return ret;
+}
+module_init(ov02c10_driver_init);
+
+static void __exit ov02c10_driver_exit(void)
+{
+	i2c_del_driver(&ov02c10_i2c_driver);
+	ov02c10_free_mode_deltas();
+	ov02c10_free_burst_tables();
+}
+module_exit(ov02c10_driver_exit);
 
 MODULE_AUTHOR("Hao Yao <hao.yao@intel.com>");
 MODULE_AUTHOR("Heimir Thor Sverrisson <heimir.sverrisson@gmail.com>");
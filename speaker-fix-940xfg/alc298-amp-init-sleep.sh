@@ -13,7 +13,7 @@ case "$1" in
     post)
         case "$2" in
             suspend|hibernate|hybrid-sleep|suspend-then-hibernate)
-                /usr/local/sbin/alc298-amp-init.sh || true
+                /usr/local/sbin/alc298-amp-init || true
                 ;;
         esac
         ;;
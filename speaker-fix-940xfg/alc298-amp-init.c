@@ -0,0 +1,357 @@
+/*
+ * alc298-amp-init — initialize internal speaker amps on the Samsung
+ * Galaxy Book3 Pro 14" (940XFG, ALC298, SSID 0x144dc882).
+ *
+ * Native replacement for alc298-amp-init.sh: instead of relying on
+ * systemd ordering and a ConditionPathExists on /dev/snd/hwC0D0 (which
+ * silently skips the init when the codec comes up late), this tool
+ * polls for the codec itself with exponential backoff in milliseconds
+ * and fires the COEF sequence the moment it appears. Audio-ready time
+ * tracks the actual codec bring-up on every boot — no fixed delay to
+ * be too long on fast boots or too short on slow ones — and the
+ * hda-verb dependency goes away: verbs are written directly through
+ * the snd-hda hwdep ioctl, one process for the whole sequence instead
+ * of one fork per verb.
+ *
+ * The COEF sequence is unchanged from the script: upstream V2_4_AMPS
+ * layout for NIDs 0x38/0x39/0x3C/0x3D plus the SKU-specific
+ * {0x239e, 0x0004} enable extension the 14" variant needs.
+ *
+ * Build:  gcc -O2 -Wall -o alc298-amp-init alc298-amp-init.c
+ * Usage:  alc298-amp-init [--timeout=SEC] [--verbose]
+ *
+ * Exits 0 when the amps were initialized, and also when no matching
+ * codec appeared within the timeout (so systemd doesn't log a failure
+ * on hardware that already works upstream); 1 on real I/O errors.
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+
+/* snd-hda hwdep verb interface (same ioctls hda-verb uses) */
+struct hda_verb_ioctl {
+	uint32_t verb;
+	uint32_t res;
+};
+#define HDA_IOCTL_PVERSION	_IOR('H', 0x10, int)
+#define HDA_IOCTL_VERB_WRITE	_IOWR('H', 0x11, struct hda_verb_ioctl)
+
+#define CODEC_VENDOR_ID		"0x10ec0298"
+#define CODEC_SUBSYSTEM_ID	"0x144dc882"
+
+#define NID_PROC	0x20	/* Realtek COEF processing widget */
+#define NID_SPK_PIN	0x17	/* speaker pin widget */
+
+/* Poll backoff: 10ms doubling to a 500ms cap. */
+#define BACKOFF_START_MS	10
+#define BACKOFF_CAP_MS		500
+#define DEFAULT_TIMEOUT_SEC	15
+
+static int verbose;
+
+static long long now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void sleep_ms(int ms)
+{
+	struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+	nanosleep(&ts, NULL);
+}
+
+/* Read a sysfs attribute and compare against an expected string. */
+static int sysfs_attr_is(const char *dir, const char *attr,
+			 const char *expect)
+{
+	char path[256], buf[64];
+	int fd;
+	ssize_t n;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, attr);
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	n = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (n <= 0)
+		return 0;
+	buf[n] = '\0';
+	buf[strcspn(buf, "\n")] = '\0';
+	return strcmp(buf, expect) == 0;
+}
+
+/*
+ * Find the ALC298 with our subsystem ID. Almost always hwC0D0, but
+ * tolerate renumbered cards (USB audio, HDMI ordering). Returns the
+ * hwdep node name in out (e.g. "hwC0D0"), or -1 if absent.
+ */
+static int find_codec(char *out, size_t out_len)
+{
+	DIR *dir = opendir("/sys/class/sound");
+	struct dirent *ent;
+	int found = -1;
+
+	if (!dir)
+		return -1;
+	while ((ent = readdir(dir)) != NULL) {
+		char path[256];
+
+		if (strncmp(ent->d_name, "hwC", 3) != 0 ||
+		    strlen(ent->d_name) >= 16)
+			continue;
+		snprintf(path, sizeof(path), "/sys/class/sound/%.16s",
+			 ent->d_name);
+		if (sysfs_attr_is(path, "vendor_id", CODEC_VENDOR_ID) &&
+		    sysfs_attr_is(path, "subsystem_id",
+				  CODEC_SUBSYSTEM_ID)) {
+			snprintf(out, out_len, "%.16s", ent->d_name);
+			found = 0;
+			break;
+		}
+	}
+	closedir(dir);
+	return found;
+}
+
+static int verb_write(int fd, uint32_t verb)
+{
+	struct hda_verb_ioctl v = { .verb = verb };
+
+	if (ioctl(fd, HDA_IOCTL_VERB_WRITE, &v) < 0) {
+		fprintf(stderr,
+			"alc298-amp-init: verb 0x%08x failed: %s\n",
+			verb, strerror(errno));
+		return -1;
+	}
+	/* The ioctl succeeds even when the command never reaches the
+	 * codec (malformed verb, codec error); that surfaces as an
+	 * all-ones response. */
+	if (v.res == (uint32_t)-1) {
+		fprintf(stderr,
+			"alc298-amp-init: verb 0x%08x rejected by codec\n",
+			verb);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * 4-bit verb group with 16-bit payload (0x4xx/0x5xx style writes).
+ * The hwdep argument is hda-verb's nid<<24 | verb<<8 | param layout,
+ * so the group lands in the verb id's top nibble and the payload
+ * splits across the verb id's low byte and the 8-bit parameter.
+ */
+static int verb16(int fd, int nid, unsigned int group, unsigned int val)
+{
+	return verb_write(fd, ((uint32_t)nid << 24) | (group << 16) |
+			      (val & 0xffff));
+}
+
+static int coef_write(int fd, unsigned int idx, unsigned int val)
+{
+	if (verb16(fd, NID_PROC, 0x5, idx) < 0)	/* SET_COEF_INDEX */
+		return -1;
+	return verb16(fd, NID_PROC, 0x4, val);	/* SET_PROC_COEF */
+}
+
+/*
+ * Indirect amp write pack:
+ *   COEF[0x23] = subindex, COEF[0x25] = value, COEF[0x26] = 0xb011
+ */
+static int write_pack(int fd, unsigned int sub, unsigned int val)
+{
+	if (coef_write(fd, 0x23, sub) < 0 ||
+	    coef_write(fd, 0x25, val) < 0 ||
+	    coef_write(fd, 0x26, 0xb011) < 0)
+		return -1;
+	return 0;
+}
+
+/*
+ * Per-amp init sequences — byte-for-byte the script's tables, which
+ * match upstream V2_4_AMPS for these NIDs.
+ */
+struct coef_pair {
+	uint16_t sub;
+	uint16_t val;
+};
+
+/* Main amps (NIDs 0x38, 0x39): 18-pair init, 0x23ba=0x0094 */
+static const struct coef_pair main_left[] = {
+	{ 0x23e1, 0x0000 }, { 0x2012, 0x006f }, { 0x2014, 0x0000 },
+	{ 0x201b, 0x0001 }, { 0x201d, 0x0001 }, { 0x201f, 0x00fe },
+	{ 0x2021, 0x0000 }, { 0x2022, 0x0010 }, { 0x203d, 0x0005 },
+	{ 0x203f, 0x0003 }, { 0x2050, 0x002c }, { 0x2076, 0x000e },
+	{ 0x207c, 0x004a }, { 0x2081, 0x0003 }, { 0x2399, 0x0003 },
+	{ 0x23a4, 0x00b5 }, { 0x23a5, 0x0001 }, { 0x23ba, 0x0094 },
+};
+
+static const struct coef_pair main_right[] = {
+	{ 0x23e1, 0x0000 }, { 0x2012, 0x006f }, { 0x2014, 0x0000 },
+	{ 0x201b, 0x0002 }, { 0x201d, 0x0002 }, { 0x201f, 0x00fd },
+	{ 0x2021, 0x0001 }, { 0x2022, 0x0010 }, { 0x203d, 0x0005 },
+	{ 0x203f, 0x0003 }, { 0x2050, 0x002c }, { 0x2076, 0x000e },
+	{ 0x207c, 0x004a }, { 0x2081, 0x0003 }, { 0x2399, 0x0003 },
+	{ 0x23a4, 0x00b5 }, { 0x23a5, 0x0001 }, { 0x23ba, 0x0094 },
+};
+
+/* Secondary amps (NIDs 0x3C, 0x3D): 15-pair init, 0x23ba=0x008d
+ * (no 0x2399/0x23a4/0x23a5) */
+static const struct coef_pair sec_left[] = {
+	{ 0x23e1, 0x0000 }, { 0x2012, 0x006f }, { 0x2014, 0x0000 },
+	{ 0x201b, 0x0001 }, { 0x201d, 0x0001 }, { 0x201f, 0x00fe },
+	{ 0x2021, 0x0000 }, { 0x2022, 0x0010 }, { 0x203d, 0x0005 },
+	{ 0x203f, 0x0003 }, { 0x2050, 0x002c }, { 0x2076, 0x000e },
+	{ 0x207c, 0x004a }, { 0x2081, 0x0003 }, { 0x23ba, 0x008d },
+};
+
+static const struct coef_pair sec_right[] = {
+	{ 0x23e1, 0x0000 }, { 0x2012, 0x006f }, { 0x2014, 0x0000 },
+	{ 0x201b, 0x0002 }, { 0x201d, 0x0002 }, { 0x201f, 0x00fd },
+	{ 0x2021, 0x0001 }, { 0x2022, 0x0010 }, { 0x203d, 0x0005 },
+	{ 0x203f, 0x0003 }, { 0x2050, 0x002c }, { 0x2076, 0x000e },
+	{ 0x207c, 0x004a }, { 0x2081, 0x0003 }, { 0x23ba, 0x008d },
+};
+
+static int init_amp(int fd, int nid, const struct coef_pair *seq, int n)
+{
+	if (coef_write(fd, 0x22, nid) < 0)	/* select amp */
+		return -1;
+	for (int i = 0; i < n; i++)
+		if (write_pack(fd, seq[i].sub, seq[i].val) < 0)
+			return -1;
+	return coef_write(fd, 0x89, 0x0000);
+}
+
+/* V2 enable_seq + the {0x239e, 0x0004} write that V2_4 upstream omits */
+static int enable_amp(int fd, int nid)
+{
+	if (coef_write(fd, 0x22, nid) < 0 ||
+	    write_pack(fd, 0x203a, 0x0081) < 0 ||
+	    write_pack(fd, 0x23ff, 0x0001) < 0 ||
+	    write_pack(fd, 0x239e, 0x0004) < 0)
+		return -1;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int timeout_sec = DEFAULT_TIMEOUT_SEC;
+
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--timeout=", 10) == 0) {
+			timeout_sec = atoi(argv[i] + 10);
+		} else if (strcmp(argv[i], "--verbose") == 0) {
+			verbose = 1;
+		} else {
+			fprintf(stderr,
+				"Usage: %s [--timeout=SEC] [--verbose]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	/*
+	 * Wait for the codec: sysfs entry with our IDs, then the hwdep
+	 * device node (udev can lag sysfs by a few ms). Exponential
+	 * backoff keeps the fast path fast — a codec that is already
+	 * up costs one scan and zero sleeps — without hammering sysfs
+	 * on slow boots.
+	 */
+	long long start = now_ms();
+	long long deadline = start + (long long)timeout_sec * 1000;
+	int backoff = BACKOFF_START_MS;
+	char name[32];
+	int fd = -1;
+
+	for (;;) {
+		if (find_codec(name, sizeof(name)) == 0) {
+			char dev[64];
+
+			snprintf(dev, sizeof(dev), "/dev/snd/%s", name);
+			fd = open(dev, O_RDWR);
+			if (fd >= 0)
+				break;
+			if (errno != ENOENT && errno != EACCES) {
+				fprintf(stderr,
+					"alc298-amp-init: cannot open"
+					" %s: %s\n", dev,
+					strerror(errno));
+				return 1;
+			}
+			/* node not created/chowned yet: keep waiting */
+		}
+		if (now_ms() >= deadline) {
+			fprintf(stderr,
+				"alc298-amp-init: no ALC298 codec with"
+				" SSID %s after %ds, exiting\n",
+				CODEC_SUBSYSTEM_ID, timeout_sec);
+			return 0;	/* wrong hardware, not a failure */
+		}
+		if (verbose)
+			fprintf(stderr,
+				"alc298-amp-init: codec not ready,"
+				" retrying in %dms\n", backoff);
+		sleep_ms(backoff);
+		if (backoff < BACKOFF_CAP_MS) {
+			backoff *= 2;
+			if (backoff > BACKOFF_CAP_MS)
+				backoff = BACKOFF_CAP_MS;
+		}
+	}
+
+	int waited = (int)(now_ms() - start);
+
+	int version = 0;
+	if (ioctl(fd, HDA_IOCTL_PVERSION, &version) < 0) {
+		fprintf(stderr,
+			"alc298-amp-init: %s is not an HDA hwdep node:"
+			" %s\n", name, strerror(errno));
+		close(fd);
+		return 1;
+	}
+
+	if (init_amp(fd, 0x38, main_left,
+		     sizeof(main_left) / sizeof(main_left[0])) < 0 ||
+	    init_amp(fd, 0x39, main_right,
+		     sizeof(main_right) / sizeof(main_right[0])) < 0 ||
+	    init_amp(fd, 0x3C, sec_left,
+		     sizeof(sec_left) / sizeof(sec_left[0])) < 0 ||
+	    init_amp(fd, 0x3D, sec_right,
+		     sizeof(sec_right) / sizeof(sec_right[0])) < 0 ||
+	    enable_amp(fd, 0x38) < 0 || enable_amp(fd, 0x39) < 0 ||
+	    enable_amp(fd, 0x3C) < 0 || enable_amp(fd, 0x3D) < 0) {
+		close(fd);
+		return 1;
+	}
+
+	/* Assert speaker pin output and unmute (idempotent). */
+	if (verb_write(fd, ((uint32_t)NID_SPK_PIN << 24) |
+			   (0x707 << 8) | 0x40) < 0 ||	/* PIN_WIDGET_CONTROL: OUT */
+	    verb16(fd, NID_SPK_PIN, 0x3, 0xb000) < 0) {	/* AMP_GAIN_MUTE: unmute out */
+		close(fd);
+		return 1;
+	}
+	close(fd);
+
+	openlog("alc298-amp-init", LOG_PID, LOG_DAEMON);
+	syslog(LOG_INFO,
+	       "Initialized ALC298 internal speaker amps on /dev/snd/%s"
+	       " (codec ready after %dms)", name, waited);
+	closelog();
+
+	return 0;
+}
@@ -9,7 +9,10 @@ set -e
 # the codec's internal class-D amps are initialized via Realtek COEF writes.
 #
 # What gets installed:
-#   /usr/local/sbin/alc298-amp-init.sh            (the init script)
+#   /usr/local/sbin/alc298-amp-init               (compiled codec poller; the
+#                                                  .sh script is installed at
+#                                                  the same path when gcc is
+#                                                  unavailable)
 #   /etc/systemd/system/alc298-amp-init.service   (runs at boot)
 #   /lib/systemd/system-sleep/alc298-amp-init     (runs after resume from sleep)
 #
@@ -101,28 +104,38 @@ echo "Hardware check passed: $VENDOR $PRODUCT, ALC298 SSID 0x144dc882"
 echo ""
 
 # ---------------------------------------------------------------------------
-# Dependency: alsa-tools (provides hda-verb)
+# Install files
 # ---------------------------------------------------------------------------
-if ! command -v hda-verb >/dev/null 2>&1; then
-    echo "Installing alsa-tools (provides hda-verb)..."
-    if [ -n "$PKG_INSTALL" ]; then
-        $PKG_INSTALL $ALSA_TOOLS_PKG || {
-            echo "ERROR: failed to install $ALSA_TOOLS_PKG. Install it manually and re-run." >&2
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+
+# Prefer the compiled poller: it waits for the codec itself (exponential
+# backoff) instead of racing systemd ordering, and needs no hda-verb.
+# The shell script goes to the same path as a fallback when gcc is
+# missing — it behaves identically once the codec is up.
+if command -v gcc >/dev/null 2>&1 && \
+   gcc -O2 -Wall -o /tmp/alc298-amp-init "${SCRIPT_DIR}/alc298-amp-init.c"; then
+    echo "Installing compiled init tool..."
+    install -m 755 /tmp/alc298-amp-init                  /usr/local/sbin/alc298-amp-init
+    rm -f /tmp/alc298-amp-init
+else
+    echo "gcc unavailable — installing script fallback (needs hda-verb)..."
+    if ! command -v hda-verb >/dev/null 2>&1; then
+        echo "Installing alsa-tools (provides hda-verb)..."
+        if [ -n "$PKG_INSTALL" ]; then
+            $PKG_INSTALL $ALSA_TOOLS_PKG || {
+                echo "ERROR: failed to install $ALSA_TOOLS_PKG. Install it manually and re-run." >&2
+                exit 1
+            }
+        else
+            echo "ERROR: unknown package manager — install $ALSA_TOOLS_PKG manually and re-run." >&2
             exit 1
-        }
-    else
-        echo "ERROR: unknown package manager — install $ALSA_TOOLS_PKG manually and re-run." >&2
-        exit 1
+        fi
     fi
+    install -m 755 "${SCRIPT_DIR}/alc298-amp-init.sh"    /usr/local/sbin/alc298-amp-init
 fi
 
-# ---------------------------------------------------------------------------
-# Install files
-# ---------------------------------------------------------------------------
-SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
-
-echo "Installing init script..."
-install -m 755 "${SCRIPT_DIR}/alc298-amp-init.sh"        /usr/local/sbin/alc298-amp-init.sh
+# Drop the old install path so stale copies don't linger
+rm -f /usr/local/sbin/alc298-amp-init.sh
 
 echo "Installing systemd boot service..."
 install -m 644 "${SCRIPT_DIR}/alc298-amp-init.service"   /etc/systemd/system/alc298-amp-init.service
@@ -138,7 +151,7 @@ systemctl enable alc298-amp-init.service
 # Fire once now so the user has working speakers without rebooting
 # ---------------------------------------------------------------------------
 echo "Activating speaker amps now..."
-if /usr/local/sbin/alc298-amp-init.sh; then
+if /usr/local/sbin/alc298-amp-init; then
     echo "✓ Speaker amps initialized"
 else
     echo "WARNING: amp init failed — check 'journalctl -t alc298-amp-init'"
@@ -14,7 +14,8 @@ systemctl stop    alc298-amp-init.service 2>/dev/null || true
 systemctl disable alc298-amp-init.service 2>/dev/null || true
 
 echo "Removing installed files..."
-rm -f /usr/local/sbin/alc298-amp-init.sh
+rm -f /usr/local/sbin/alc298-amp-init
+rm -f /usr/local/sbin/alc298-amp-init.sh   # pre-compiled-tool install path
 rm -f /etc/systemd/system/alc298-amp-init.service
 rm -f /lib/systemd/system-sleep/alc298-amp-init
 
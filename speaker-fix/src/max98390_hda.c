@@ -22,13 +22,27 @@ static void max98390_hda_playback_hook(struct device *dev, int action)
 
 	switch (action) {
 	case HDA_GEN_PCM_ACT_OPEN:
-
-		/* Enable global and speaker amp */
-		ret = regmap_write(priv->regmap, MAX98390_R23FF_GLOBAL_EN, 0x01);
+		/* First open can race the async bring-up */
+		if (!wait_for_completion_timeout(&priv->init_done,
+						 msecs_to_jiffies(2000)))
+			dev_warn(dev, "Amp init still pending at PCM open\n");
+		if (priv->init_ret)
+			break;
+
+		/*
+		 * Enable global and speaker amp. update_bits reads the
+		 * current value from the regcache, so a redundant open
+		 * (or an amp already enabled) touches no I2C at all.
+		 */
+		ret = regmap_update_bits(priv->regmap,
+					 MAX98390_R23FF_GLOBAL_EN,
+					 0xff, 0x01);
 		if (ret < 0)
 			dev_err(dev, "Failed to write GLOBAL_EN: %d\n", ret);
 
-		ret = regmap_write(priv->regmap, MAX98390_R203A_AMP_EN, 0x81);
+		ret = regmap_update_bits(priv->regmap,
+					 MAX98390_R203A_AMP_EN,
+					 0xff, 0x81);
 		if (ret < 0)
 			dev_err(dev, "Failed to write AMP_EN: %d\n", ret);
 
@@ -36,8 +50,10 @@ static void max98390_hda_playback_hook(struct device *dev, int action)
 
 	case HDA_GEN_PCM_ACT_CLOSE:
 		/* Disable speaker amp and global */
-		regmap_write(priv->regmap, MAX98390_R203A_AMP_EN, 0x80);
-		regmap_write(priv->regmap, MAX98390_R23FF_GLOBAL_EN, 0x00);
+		regmap_update_bits(priv->regmap, MAX98390_R203A_AMP_EN,
+				   0xff, 0x80);
+		regmap_update_bits(priv->regmap, MAX98390_R23FF_GLOBAL_EN,
+				   0xff, 0x00);
 		break;
 
 	default:
@@ -88,12 +104,6 @@ static const struct component_ops max98390_hda_comp_ops = {
 static int max98390_hda_init(struct max98390_hda_priv *priv)
 {
 	int ret;
-	unsigned int reg;
-
-	/* Check device ID */
-	ret = regmap_read(priv->regmap, MAX98390_R24FF_REV_ID, &reg);
-	if (ret < 0)
-		return ret;
 
 	/* Software reset */
 	ret = regmap_write(priv->regmap, MAX98390_SOFTWARE_RESET, 0x01);
@@ -136,11 +146,32 @@ static int max98390_hda_init(struct max98390_hda_priv *priv)
 	return 0;
 }
 
+/*
+ * Per-amp bring-up work. The four amps are independent I2C devices
+ * whose DSM loads don't depend on each other, so each runs from its
+ * own work item: the transfers overlap instead of running as one
+ * serial loop in the bind path, and HDA probe no longer waits on amp
+ * programming at all. The playback hook waits on init_done before
+ * first enable.
+ */
+static void max98390_hda_init_work(struct work_struct *work)
+{
+	struct max98390_hda_priv *priv =
+		container_of(work, struct max98390_hda_priv, init_work);
+
+	priv->init_ret = max98390_hda_init(priv);
+	if (priv->init_ret)
+		dev_err(priv->dev, "Amp init failed: %d\n",
+			priv->init_ret);
+	complete_all(&priv->init_done);
+}
+
 int max98390_hda_probe(struct device *dev, const char *device_name,
 		       int id, int irq, struct regmap *regmap,
 		       enum max98390_hda_bus_type bus_type, int i2c_addr)
 {
 	struct max98390_hda_priv *priv;
+	unsigned int reg;
 	int ret;
 
 	priv = devm_kzalloc(dev, sizeof(*priv), GFP_KERNEL);
@@ -155,13 +186,21 @@ int max98390_hda_probe(struct device *dev, const char *device_name,
 	priv->i2c_addr = i2c_addr;
 	dev_set_drvdata(dev, priv);
 
-	ret = max98390_hda_init(priv);
-	if (ret)
+	/* Presence check stays synchronous so a missing amp still
+	 * fails the probe; the heavy programming goes async. */
+	ret = regmap_read(priv->regmap, MAX98390_R24FF_REV_ID, &reg);
+	if (ret < 0)
 		return ret;
 
+	init_completion(&priv->init_done);
+	INIT_WORK(&priv->init_work, max98390_hda_init_work);
+	schedule_work(&priv->init_work);
+
 	ret = component_add(dev, &max98390_hda_comp_ops);
-	if (ret)
+	if (ret) {
+		cancel_work_sync(&priv->init_work);
 		return ret;
+	}
 
 	return 0;
 }
@@ -173,6 +212,9 @@ void max98390_hda_remove(struct device *dev)
 
 	component_del(dev, &max98390_hda_comp_ops);
 
+	if (priv)
+		cancel_work_sync(&priv->init_work);
+
 	if (priv && priv->regmap) {
 		/* Disable amp on removal */
 		regmap_write(priv->regmap, MAX98390_R203A_AMP_EN, 0x80);
@@ -184,6 +226,9 @@ static int max98390_hda_runtime_suspend(struct device *dev)
 {
 	struct max98390_hda_priv *priv = dev_get_drvdata(dev);
 
+	/* Don't cache-only the map under a still-running init */
+	flush_work(&priv->init_work);
+
 	regmap_write(priv->regmap, MAX98390_R203A_AMP_EN, 0x80);
 	regcache_cache_only(priv->regmap, true);
 	regcache_mark_dirty(priv->regmap);
@@ -194,10 +239,33 @@ static int max98390_hda_runtime_suspend(struct device *dev)
 static int max98390_hda_runtime_resume(struct device *dev)
 {
 	struct max98390_hda_priv *priv = dev_get_drvdata(dev);
+	unsigned int sentinel = 0;
 
 	regcache_cache_only(priv->regmap, false);
+
+	/*
+	 * The DSM parameter block never changes at runtime, and on
+	 * s2idle the part usually keeps it. Read the sentinel (the
+	 * blob's last byte) from hardware: if it survived, keep the
+	 * whole 913-register region out of the per-register sync and
+	 * skip the reload entirely; only a part that actually lost
+	 * power gets the blob streamed again (as bursts).
+	 */
+	regcache_cache_bypass(priv->regmap, true);
+	regmap_read(priv->regmap, MAX98390_DSM_LAST_ADDR, &sentinel);
+	regcache_cache_bypass(priv->regmap, false);
+
+	regcache_drop_region(priv->regmap, MAX98390_DSM_START_ADDR,
+			     MAX98390_DSM_LAST_ADDR);
 	regcache_sync(priv->regmap);
 
+	if (priv->dsm_loaded && sentinel != priv->dsm_sentinel) {
+		dev_dbg(dev, "DSM lost across suspend, reloading\n");
+		/* The shadow no longer mirrors the part: full reload */
+		priv->dsm_valid = false;
+		max98390_configure_filters(priv);
+	}
+
 	return 0;
 }
 
@@ -6,9 +6,13 @@
 #ifndef __MAX98390_HDA_H__
 #define __MAX98390_HDA_H__
 
+#include <linux/completion.h>
 #include <linux/regmap.h>
+#include <linux/workqueue.h>
 #include <sound/hda_codec.h>
 
+#include "max98390_hda_filters.h"
+
 enum max98390_hda_bus_type {
 	MAX98390_HDA_I2C,
 };
@@ -21,6 +25,13 @@ struct max98390_hda_priv {
 	int index;
 	const char *acpi_subsystem_id;
 	int i2c_addr;  /* I2C address for speaker identification */
+	struct work_struct init_work;  /* async amp bring-up */
+	struct completion init_done;
+	int init_ret;  /* result of the async init */
+	bool dsm_loaded;  /* DSM blob has been programmed */
+	u8 dsm_sentinel;  /* expected last byte of the blob */
+	bool dsm_valid;  /* dsm_shadow mirrors the part */
+	u8 dsm_shadow[MAX98390_DSM_PARAM_SIZE];  /* programmed blob */
 };
 
 int max98390_hda_probe(struct device *dev, const char *device_name,
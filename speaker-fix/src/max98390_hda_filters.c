@@ -4,6 +4,7 @@
 // Based on PR #5616 from thesofproject/linux by Kevin Cuperus
 //
 
+#include <linux/firmware.h>
 #include <linux/module.h>
 #include <linux/i2c.h>
 #include "max98390_hda.h"
@@ -49,9 +50,6 @@ void max98390_configure_filters(struct max98390_hda_priv *priv)
 }
 
 /* Complete DSM firmware blobs from Google Redrix */
-#define MAX98390_DSM_START_ADDR 0x2050
-#define MAX98390_DSM_PARAM_SIZE 913
-
 /* Woofer DSM firmware (for 0x38, 0x39) */
 static const u8 max98390_dsm_firmware_woofer[] = {
 	0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F,
@@ -172,33 +170,148 @@ static const u8 max98390_dsm_firmware_tweeter[] = {
 	0x20,
 };
 
-/* Load complete DSM firmware blob */
-static void max98390_load_dsm_firmware(struct max98390_hda_priv *priv, bool is_tweeter)
+/* Bytes per raw I2C transfer when bursting the DSM blob */
+#define MAX98390_DSM_BURST_SIZE 128
+
+/* Rewriting a short unchanged gap is cheaper than splitting a burst */
+#define MAX98390_DSM_DELTA_GAP 8
+
+/*
+ * Loadable tuning profiles (max98390/tuning-woofer.bin and
+ * max98390/tuning-tweeter.bin under the firmware search path): a
+ * small header followed by the raw DSM parameter block, so a tuning
+ * tweak ships as a firmware file instead of a module rebuild. The
+ * built-in Redrix blobs remain the fallback whenever no file is
+ * present or it fails validation.
+ */
+#define MAX98390_TUNING_MAGIC 0x3154394d	/* "M9T1" */
+
+struct max98390_tuning_hdr {
+	__le32 magic;
+	__le16 param_size;	/* must equal MAX98390_DSM_PARAM_SIZE */
+	u8 vol_ctrl;		/* value for DSM_VOL_CTRL (0x23BA) */
+	u8 reserved;
+} __packed;
+
+/* Write blob[offset..offset+len) in auto-increment bursts */
+static int max98390_dsm_burst_write(struct max98390_hda_priv *priv,
+				    const u8 *blob, int offset, int len)
+{
+	while (len > 0) {
+		int chunk = min(len, MAX98390_DSM_BURST_SIZE);
+		int ret = regmap_raw_write(priv->regmap,
+					   MAX98390_DSM_START_ADDR + offset,
+					   blob + offset, chunk);
+
+		if (ret < 0)
+			return ret;
+		offset += chunk;
+		len -= chunk;
+	}
+	return 0;
+}
+
+/*
+ * Program a DSM parameter block. The first load streams the whole
+ * blob; after that a shadow of what is on the part lets a profile
+ * switch write only the registers that actually differ, coalescing
+ * nearby changes into single transfers.
+ */
+static void max98390_program_dsm(struct max98390_hda_priv *priv,
+				 const u8 *blob)
 {
-	const u8 *firmware;
-	int i;
+	int i = 0;
+	int ret = 0;
+
+	if (!priv->dsm_valid) {
+		ret = max98390_dsm_burst_write(priv, blob, 0,
+					       MAX98390_DSM_PARAM_SIZE);
+	} else {
+		while (i < MAX98390_DSM_PARAM_SIZE && ret == 0) {
+			int start, end, gap = 0;
 
-	if (is_tweeter)
-		firmware = max98390_dsm_firmware_tweeter;
-	else
-		firmware = max98390_dsm_firmware_woofer;
+			while (i < MAX98390_DSM_PARAM_SIZE &&
+			       blob[i] == priv->dsm_shadow[i])
+				i++;
+			if (i >= MAX98390_DSM_PARAM_SIZE)
+				break;
+			start = i;
+			end = i + 1;
+			while (i < MAX98390_DSM_PARAM_SIZE &&
+			       gap <= MAX98390_DSM_DELTA_GAP) {
+				if (blob[i] != priv->dsm_shadow[i]) {
+					end = i + 1;
+					gap = 0;
+				} else {
+					gap++;
+				}
+				i++;
+			}
+			i = end;
+			ret = max98390_dsm_burst_write(priv, blob, start,
+						       end - start);
+		}
+	}
 
-	/* Write all 913 bytes sequentially starting from 0x2050 */
-	for (i = 0; i < MAX98390_DSM_PARAM_SIZE; i++)
-		regmap_write(priv->regmap, MAX98390_DSM_START_ADDR + i, firmware[i]);
+	if (ret < 0) {
+		/* Adapter refused the burst - fall back to byte writes */
+		dev_warn(priv->dev,
+			 "DSM burst write failed (%d), using byte writes\n",
+			 ret);
+		for (i = 0; i < MAX98390_DSM_PARAM_SIZE; i++)
+			regmap_write(priv->regmap,
+				     MAX98390_DSM_START_ADDR + i, blob[i]);
+	}
+
+	memcpy(priv->dsm_shadow, blob, MAX98390_DSM_PARAM_SIZE);
+	priv->dsm_valid = true;
+
+	/* Remember what resume should find in the sentinel register */
+	priv->dsm_loaded = true;
+	priv->dsm_sentinel = blob[MAX98390_DSM_PARAM_SIZE - 1];
 }
 
 /* Configure DSM with appropriate firmware based on speaker type */
 void max98390_configure_high_pass_filter(struct max98390_hda_priv *priv, int cutoff_freq, bool is_tweeter)
 {
-	/* Load complete DSM firmware (913 bytes, all registers) */
-	max98390_load_dsm_firmware(priv, is_tweeter);
+	const struct firmware *fw = NULL;
+	const u8 *blob;
+	u8 vol_ctrl;
+	char fw_name[32];
 
-	/* Set DSM_VOL_CTRL - Tweeter more quiet than woofer */
-	if (is_tweeter)
-		regmap_write(priv->regmap, 0x23BA, 0x8d);
-	else
-		regmap_write(priv->regmap, 0x23BA, 0xA0);
+	if (is_tweeter) {
+		blob = max98390_dsm_firmware_tweeter;
+		vol_ctrl = 0x8d;	/* Tweeter more quiet than woofer */
+	} else {
+		blob = max98390_dsm_firmware_woofer;
+		vol_ctrl = 0xA0;
+	}
+
+	snprintf(fw_name, sizeof(fw_name), "max98390/tuning-%s.bin",
+		 is_tweeter ? "tweeter" : "woofer");
+	if (firmware_request_nowarn(&fw, fw_name, priv->dev) == 0) {
+		const struct max98390_tuning_hdr *hdr =
+			(const void *)fw->data;
+
+		if (fw->size >= sizeof(*hdr) + MAX98390_DSM_PARAM_SIZE &&
+		    le32_to_cpu(hdr->magic) == MAX98390_TUNING_MAGIC &&
+		    le16_to_cpu(hdr->param_size) == MAX98390_DSM_PARAM_SIZE) {
+			blob = fw->data + sizeof(*hdr);
+			vol_ctrl = hdr->vol_ctrl;
+			dev_info(priv->dev, "Using tuning profile %s\n",
+				 fw_name);
+		} else {
+			dev_warn(priv->dev,
+				 "Invalid tuning profile %s, using built-in\n",
+				 fw_name);
+		}
+	}
+
+	/* Load the DSM parameter block (913 bytes, all registers) */
+	max98390_program_dsm(priv, blob);
+
+	/* Set DSM_VOL_CTRL */
+	regmap_write(priv->regmap, 0x23BA, vol_ctrl);
 
 	/* SET DSP_GLOBAL_EN TO 1 */
 	regmap_write(priv->regmap, 0x23E1, 0x01);
@@ -208,8 +321,13 @@ void max98390_configure_high_pass_filter(struct max98390_hda_priv *priv, int cut
 
 	/* SET EN TO 1 */
 	regmap_write(priv->regmap, 0x23FF, 0x01);
+
+	release_firmware(fw);
 }
 
+MODULE_FIRMWARE("max98390/tuning-woofer.bin");
+MODULE_FIRMWARE("max98390/tuning-tweeter.bin");
+
 MODULE_DESCRIPTION("HDA MAX98390 filter configuration");
 MODULE_AUTHOR("Kevin Cuperus <cuperus.kevin@hotmail.com>");
 MODULE_LICENSE("GPL");
@@ -8,6 +8,17 @@
 
 struct max98390_hda_priv;
 
+/*
+ * DSM parameter block layout. The last byte of the blob doubles as
+ * the resume sentinel: it differs between the woofer (0x21) and
+ * tweeter (0x20) images, so reading it back also catches a wrong or
+ * partially-written blob, not just a reset part.
+ */
+#define MAX98390_DSM_START_ADDR	0x2050
+#define MAX98390_DSM_PARAM_SIZE	913
+#define MAX98390_DSM_LAST_ADDR \
+	(MAX98390_DSM_START_ADDR + MAX98390_DSM_PARAM_SIZE - 1)
+
 void max98390_configure_filters(struct max98390_hda_priv *priv);
 void max98390_configure_high_pass_filter(struct max98390_hda_priv *priv, int cutoff_freq, bool is_tweeter);
 
@@ -12,6 +12,8 @@
 
 /* MAX98390 Register Addresses */
 #define MAX98390_SOFTWARE_RESET			0x2000
+#define MAX98390_INT_RAW1			0x2001
+#define MAX98390_INT_STATE3			0x200f
 #define MAX98390_CLK_MON			0x2012
 #define MAX98390_DAT_MON			0x2014
 #define MAX98390_PCM_RX_EN_A			0x201b
@@ -31,15 +33,46 @@
 
 /*
  * Local regmap config for the HDA side-codec I2C driver.
- * We use REGCACHE_NONE since we don't have the full reg_defaults table
- * from the ASoC driver. This means every read hits hardware, which is
- * acceptable for an initialization-heavy driver like this.
+ *
+ * REGCACHE_MAPLE without reg_defaults: the cache fills lazily from
+ * our own writes (and reads on first access), which covers everything
+ * this driver touches. With the cache in place the playback hooks'
+ * update_bits calls read from cache instead of the wire, and the
+ * suspend path's regcache_cache_only/regcache_sync pair actually
+ * replays state on resume instead of being a no-op.
  */
+static bool max98390_volatile_reg(struct device *dev, unsigned int reg)
+{
+	switch (reg) {
+	case MAX98390_SOFTWARE_RESET:
+	case MAX98390_INT_RAW1 ... MAX98390_INT_STATE3:
+	case MAX98390_R24FF_REV_ID:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool max98390_readable_reg(struct device *dev, unsigned int reg)
+{
+	return reg >= MAX98390_SOFTWARE_RESET &&
+	       reg <= MAX98390_R24FF_REV_ID;
+}
+
 static const struct regmap_config max98390_regmap = {
 	.reg_bits	= 16,
 	.val_bits	= 8,
 	.max_register	= MAX98390_R24FF_REV_ID,
-	.cache_type	= REGCACHE_NONE,
+	.cache_type	= REGCACHE_MAPLE,
+	.volatile_reg	= max98390_volatile_reg,
+	.readable_reg	= max98390_readable_reg,
+	/*
+	 * The device auto-increments the register address within one
+	 * I2C write, so raw/bulk writes (used for the DSM firmware
+	 * load) may span register ranges in a single transfer.
+	 */
+	.use_single_write = false,
+	.use_single_read = false,
 };
 
 #endif /* __MAX98390_REGS_H__ */
@@ -18,6 +18,19 @@ DKMS_VER=$(dkms status 2>/dev/null \
 
 log() { echo "ipu-bridge-check: $*"; }
 
+# Persist the module's SSDB parse cache so the next load skips the ACPI
+# evaluation entirely (ssdb_cache parameter, see ipu-bridge.c). Entries
+# are keyed on DMI product + ACPI device name, so a cache recorded on
+# another machine is ignored by the module.
+SSDB_CACHE_PARAM=/sys/module/ipu_bridge/parameters/ssdb_cache
+SSDB_CACHE_CONF=/etc/modprobe.d/ipu-bridge-ssdb-cache.conf
+if [ -r "$SSDB_CACHE_PARAM" ]; then
+    SSDB_CACHE=$(tr -d '\n' < "$SSDB_CACHE_PARAM")
+    if [ -n "$SSDB_CACHE" ]; then
+        echo "options ipu-bridge ssdb_cache=\"$SSDB_CACHE\"" > "$SSDB_CACHE_CONF"
+    fi
+fi
+
 # Find the kernel's own ipu-bridge module (in kernel/ tree, NOT updates/)
 NATIVE_MODULE=$(find "/lib/modules/$(uname -r)/kernel" -name "ipu-bridge*" 2>/dev/null | head -1)
 
@@ -66,6 +79,7 @@ rm -rf "/usr/src/ov02e10-fix-1.0"
 # Remove installed files
 rm -f /etc/systemd/system/ipu-bridge-check-upstream.service
 rm -f /usr/local/sbin/ipu-bridge-check-upstream.sh
+rm -f "$SSDB_CACHE_CONF"
 rm -rf "/usr/src/${DKMS_NAME}-${DKMS_VER}"
 
 # Rebuild module dependency map so kernel's original modules are used
@@ -8,6 +8,8 @@
 #include <linux/dmi.h>
 #include <linux/i2c.h>
 #include <linux/mei_cl_bus.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
 #include <linux/property.h>
@@ -223,6 +225,175 @@ static const char * const ipu_vcm_types[] = {
 	"lc898212axb",
 };
 
+/*
+ * SSDB parse cache. The SSDB blob, rotation and _PLD orientation are
+ * invariant for a given machine, yet every module load re-evaluates
+ * the ACPI methods - slow, and serialized kernel-wide. The resolved
+ * values are exported through the ssdb_cache module parameter, keyed
+ * on DMI product name + ACPI device name; userspace persists the
+ * parameter to modprobe.d after the first load so later loads skip
+ * the ACPI interpreter entirely. Entries recorded on a different
+ * machine are ignored.
+ *
+ * Record format, space separated:
+ *   <product>/<acpi-dev>:<link>,<lanes>,<mclk>,<rot>,<orient>,<vcm>
+ */
+struct ipu_bridge_ssdb_cache_entry {
+	char dev_name[32];
+	u32 link;
+	u32 lanes;
+	u32 mclkspeed;
+	u32 rotation;
+	u32 orientation;
+	u32 vcmtype;
+};
+
+static struct ipu_bridge_ssdb_cache_entry ipu_bridge_ssdb_cache[IPU_MAX_PORTS];
+static unsigned int ipu_bridge_ssdb_cache_len;
+static DEFINE_MUTEX(ipu_bridge_ssdb_cache_lock);
+
+static void ipu_bridge_dmi_product(char *buf, size_t len)
+{
+	const char *product = dmi_get_system_info(DMI_PRODUCT_NAME);
+	size_t i;
+
+	strscpy(buf, product ?: "unknown", len);
+	/* Spaces would split the record */
+	for (i = 0; buf[i]; i++)
+		if (buf[i] == ' ')
+			buf[i] = '_';
+}
+
+static int ipu_bridge_ssdb_cache_set(const char *val,
+				     const struct kernel_param *kp)
+{
+	char this_product[64], product[64];
+	char *str, *orig, *tok;
+	unsigned int len = 0;
+
+	str = kstrdup(val, GFP_KERNEL);
+	if (!str)
+		return -ENOMEM;
+	orig = str;
+
+	ipu_bridge_dmi_product(this_product, sizeof(this_product));
+
+	mutex_lock(&ipu_bridge_ssdb_cache_lock);
+	while ((tok = strsep(&str, " \n")) != NULL) {
+		struct ipu_bridge_ssdb_cache_entry e;
+
+		if (!*tok)
+			continue;
+		if (len >= IPU_MAX_PORTS)
+			break;
+		if (sscanf(tok, "%63[^/]/%31[^:]:%u,%u,%u,%u,%u,%u",
+			   product, e.dev_name, &e.link, &e.lanes,
+			   &e.mclkspeed, &e.rotation, &e.orientation,
+			   &e.vcmtype) != 8)
+			continue;
+		if (strcmp(product, this_product) != 0)
+			continue;
+		if (e.lanes > IPU_MAX_LANES ||
+		    e.vcmtype > ARRAY_SIZE(ipu_vcm_types))
+			continue;
+		ipu_bridge_ssdb_cache[len++] = e;
+	}
+	ipu_bridge_ssdb_cache_len = len;
+	mutex_unlock(&ipu_bridge_ssdb_cache_lock);
+
+	kfree(orig);
+	return 0;
+}
+
+static int ipu_bridge_ssdb_cache_get(char *buffer,
+				     const struct kernel_param *kp)
+{
+	char product[64];
+	unsigned int i;
+	int len = 0;
+
+	ipu_bridge_dmi_product(product, sizeof(product));
+
+	mutex_lock(&ipu_bridge_ssdb_cache_lock);
+	for (i = 0; i < ipu_bridge_ssdb_cache_len; i++) {
+		const struct ipu_bridge_ssdb_cache_entry *e =
+			&ipu_bridge_ssdb_cache[i];
+
+		len += scnprintf(buffer + len, PAGE_SIZE - len,
+				 "%s%s/%s:%u,%u,%u,%u,%u,%u",
+				 len ? " " : "", product, e->dev_name,
+				 e->link, e->lanes, e->mclkspeed, e->rotation,
+				 e->orientation, e->vcmtype);
+	}
+	mutex_unlock(&ipu_bridge_ssdb_cache_lock);
+
+	return len;
+}
+
+static const struct kernel_param_ops ipu_bridge_ssdb_cache_ops = {
+	.set = ipu_bridge_ssdb_cache_set,
+	.get = ipu_bridge_ssdb_cache_get,
+};
+module_param_cb(ssdb_cache, &ipu_bridge_ssdb_cache_ops, NULL, 0644);
+MODULE_PARM_DESC(ssdb_cache,
+		 "Cached SSDB/orientation parse results, keyed on DMI product + ACPI device");
+
+static bool ipu_bridge_ssdb_cache_lookup(struct acpi_device *adev,
+					 struct ipu_sensor *sensor)
+{
+	unsigned int i;
+
+	guard(mutex)(&ipu_bridge_ssdb_cache_lock);
+
+	for (i = 0; i < ipu_bridge_ssdb_cache_len; i++) {
+		const struct ipu_bridge_ssdb_cache_entry *e =
+			&ipu_bridge_ssdb_cache[i];
+
+		if (strcmp(e->dev_name, acpi_dev_name(adev)) != 0)
+			continue;
+
+		sensor->link = e->link;
+		sensor->lanes = e->lanes;
+		sensor->mclkspeed = e->mclkspeed;
+		sensor->rotation = e->rotation;
+		sensor->orientation = e->orientation;
+		if (e->vcmtype)
+			sensor->vcm_type = ipu_vcm_types[e->vcmtype - 1];
+		return true;
+	}
+
+	return false;
+}
+
+static void ipu_bridge_ssdb_cache_store(struct acpi_device *adev,
+					const struct ipu_sensor *sensor,
+					u32 vcmtype)
+{
+	struct ipu_bridge_ssdb_cache_entry *e;
+	unsigned int i;
+
+	guard(mutex)(&ipu_bridge_ssdb_cache_lock);
+
+	for (i = 0; i < ipu_bridge_ssdb_cache_len; i++)
+		if (strcmp(ipu_bridge_ssdb_cache[i].dev_name,
+			   acpi_dev_name(adev)) == 0)
+			break;
+	if (i == ipu_bridge_ssdb_cache_len) {
+		if (i >= IPU_MAX_PORTS)
+			return;
+		ipu_bridge_ssdb_cache_len++;
+	}
+
+	e = &ipu_bridge_ssdb_cache[i];
+	strscpy(e->dev_name, acpi_dev_name(adev), sizeof(e->dev_name));
+	e->link = sensor->link;
+	e->lanes = sensor->lanes;
+	e->mclkspeed = sensor->mclkspeed;
+	e->rotation = sensor->rotation;
+	e->orientation = sensor->orientation;
+	e->vcmtype = vcmtype;
+}
+
 /*
  * Used to figure out IVSC acpi device by ipu_bridge_get_ivsc_acpi_dev()
  * instead of device and driver match to probe IVSC device.
@@ -409,6 +580,9 @@ int ipu_bridge_parse_ssdb(struct acpi_device *adev, struct ipu_sensor *sensor)
 	struct ipu_sensor_ssdb ssdb = {};
 	int ret;
 
+	if (ipu_bridge_ssdb_cache_lookup(adev, sensor))
+		return 0;
+
 	ret = ipu_bridge_read_acpi_buffer(adev, "SSDB", &ssdb, sizeof(ssdb));
 	if (ret)
 		return ret;
@@ -432,6 +606,8 @@ int ipu_bridge_parse_ssdb(struct acpi_device *adev, struct ipu_sensor *sensor)
 	if (ssdb.vcmtype)
 		sensor->vcm_type = ipu_vcm_types[ssdb.vcmtype - 1];
 
+	ipu_bridge_ssdb_cache_store(adev, sensor, ssdb.vcmtype);
+
 	return 0;
 }
 EXPORT_SYMBOL_NS_GPL(ipu_bridge_parse_ssdb, "INTEL_IPU_BRIDGE");
@@ -772,66 +948,122 @@ static void ipu_bridge_unregister_sensors(struct ipu_bridge *bridge)
 	}
 }
 
-static int ipu_bridge_connect_sensor(const struct ipu_sensor_config *cfg,
-				     struct ipu_bridge *bridge)
+/*
+ * Sensor enumeration is split in two phases. The expensive part -
+ * ACPI buffer reads, SSDB parsing and the IVSC device lookup - has no
+ * ordering requirements between sensors, so one work item per
+ * candidate HID probes in parallel on the existing workqueue and the
+ * results are joined before any software node is registered. The
+ * software-node phase stays serial: it touches global fwnode state.
+ */
+struct ipu_bridge_probe_ctx {
+	struct ipu_bridge *bridge;
+	struct mutex lock;	/* protects n_sensors and the arrays below */
+	struct acpi_device *adevs[IPU_MAX_PORTS];
+	const struct ipu_sensor_config *cfgs[IPU_MAX_PORTS];
+	int ret;		/* first probe error */
+};
+
+struct ipu_bridge_probe_work {
+	struct work_struct work;
+	struct ipu_bridge_probe_ctx *ctx;
+	const struct ipu_sensor_config *cfg;
+};
+
+static void ipu_bridge_probe_sensor_work(struct work_struct *work)
 {
-	struct fwnode_handle *fwnode, *primary;
-	struct ipu_sensor *sensor;
+	struct ipu_bridge_probe_work *pw =
+		container_of(work, struct ipu_bridge_probe_work, work);
+	struct ipu_bridge_probe_ctx *ctx = pw->ctx;
+	struct ipu_bridge *bridge = ctx->bridge;
 	struct acpi_device *adev = NULL;
-	int ret;
+	struct ipu_sensor *probe;
+	int ret = 0, idx;
+
+	probe = kzalloc(sizeof(*probe), GFP_KERNEL);
+	if (!probe) {
+		ret = -ENOMEM;
+		goto out;
+	}
 
-	for_each_acpi_dev_match(adev, cfg->hid, NULL, -1) {
+	for_each_acpi_dev_match(adev, pw->cfg->hid, NULL, -1) {
 		if (!ACPI_PTR(adev->status.enabled))
 			continue;
 
-		if (bridge->n_sensors >= IPU_MAX_PORTS) {
-			acpi_dev_put(adev);
-			dev_err(bridge->dev, "Exceeded available IPU ports\n");
-			return -EINVAL;
-		}
-
-		sensor = &bridge->sensors[bridge->n_sensors];
+		memset(probe, 0, sizeof(*probe));
 
-		ret = bridge->parse_sensor_fwnode(adev, sensor);
+		ret = bridge->parse_sensor_fwnode(adev, probe);
 		if (ret)
-			goto err_put_adev;
+			break;
 
-		snprintf(sensor->name, sizeof(sensor->name), "%s-%u",
-			 cfg->hid, sensor->link);
+		snprintf(probe->name, sizeof(probe->name), "%s-%u",
+			 pw->cfg->hid, probe->link);
 
-		ret = ipu_bridge_check_ivsc_dev(sensor, adev);
+		ret = ipu_bridge_check_ivsc_dev(probe, adev);
 		if (ret)
-			goto err_put_adev;
+			break;
 
-		ipu_bridge_create_fwnode_properties(sensor, bridge, cfg);
-		ipu_bridge_create_connection_swnodes(bridge, sensor);
-
-		ret = software_node_register_node_group(sensor->group);
-		if (ret)
-			goto err_put_ivsc;
-
-		fwnode = software_node_fwnode(&sensor->swnodes[
-						      SWNODE_SENSOR_HID]);
-		if (!fwnode) {
-			ret = -ENODEV;
-			goto err_free_swnodes;
+		mutex_lock(&ctx->lock);
+		if (bridge->n_sensors >= IPU_MAX_PORTS) {
+			mutex_unlock(&ctx->lock);
+			put_device(probe->csi_dev);
+			acpi_dev_put(probe->ivsc_adev);
+			dev_err(bridge->dev, "Exceeded available IPU ports\n");
+			ret = -EINVAL;
+			break;
 		}
+		idx = bridge->n_sensors++;
+		bridge->sensors[idx] = *probe;
+		ctx->adevs[idx] = ACPI_PTR(acpi_dev_get(adev));
+		ctx->cfgs[idx] = pw->cfg;
+		mutex_unlock(&ctx->lock);
+	}
 
-		sensor->adev = ACPI_PTR(acpi_dev_get(adev));
+	acpi_dev_put(adev);
+	kfree(probe);
+out:
+	if (ret) {
+		mutex_lock(&ctx->lock);
+		if (!ctx->ret)
+			ctx->ret = ret;
+		mutex_unlock(&ctx->lock);
+	}
+}
 
-		primary = acpi_fwnode_handle(adev);
-		primary->secondary = fwnode;
+static int ipu_bridge_register_sensor(struct ipu_bridge_probe_ctx *ctx,
+				      unsigned int idx)
+{
+	struct ipu_bridge *bridge = ctx->bridge;
+	struct ipu_sensor *sensor = &bridge->sensors[idx];
+	struct acpi_device *adev = ctx->adevs[idx];
+	struct fwnode_handle *fwnode, *primary;
+	int ret;
 
-		ret = ipu_bridge_instantiate_ivsc(sensor);
-		if (ret)
-			goto err_free_swnodes;
+	ipu_bridge_create_fwnode_properties(sensor, bridge, ctx->cfgs[idx]);
+	ipu_bridge_create_connection_swnodes(bridge, sensor);
 
-		dev_info(bridge->dev, "Found supported sensor %s\n",
-			 acpi_dev_name(adev));
+	ret = software_node_register_node_group(sensor->group);
+	if (ret)
+		goto err_put_ivsc;
 
-		bridge->n_sensors++;
+	fwnode = software_node_fwnode(&sensor->swnodes[SWNODE_SENSOR_HID]);
+	if (!fwnode) {
+		ret = -ENODEV;
+		goto err_free_swnodes;
 	}
 
+	sensor->adev = ACPI_PTR(acpi_dev_get(adev));
+
+	primary = acpi_fwnode_handle(adev);
+	primary->secondary = fwnode;
+
+	ret = ipu_bridge_instantiate_ivsc(sensor);
+	if (ret)
+		goto err_free_swnodes;
+
+	dev_info(bridge->dev, "Found supported sensor %s\n",
+		 acpi_dev_name(adev));
+
 	return 0;
 
 err_free_swnodes:
@@ -839,29 +1071,67 @@ err_free_swnodes:
 err_put_ivsc:
 	put_device(sensor->csi_dev);
 	acpi_dev_put(sensor->ivsc_adev);
-err_put_adev:
-	acpi_dev_put(adev);
 	return ret;
 }
 
 static int ipu_bridge_connect_sensors(struct ipu_bridge *bridge)
 {
-	unsigned int i;
+	struct ipu_bridge_probe_work works[ARRAY_SIZE(ipu_supported_sensors)];
+	struct ipu_bridge_probe_ctx ctx = { .bridge = bridge };
+	unsigned int i, n, registered = 0, released = 0;
 	int ret;
 
+	mutex_init(&ctx.lock);
+
 	for (i = 0; i < ARRAY_SIZE(ipu_supported_sensors); i++) {
-		const struct ipu_sensor_config *cfg =
-			&ipu_supported_sensors[i];
+		works[i].ctx = &ctx;
+		works[i].cfg = &ipu_supported_sensors[i];
+		INIT_WORK_ONSTACK(&works[i].work, ipu_bridge_probe_sensor_work);
+		queue_work(system_long_wq, &works[i].work);
+	}
 
-		ret = ipu_bridge_connect_sensor(cfg, bridge);
-		if (ret)
-			goto err_unregister_sensors;
+	for (i = 0; i < ARRAY_SIZE(ipu_supported_sensors); i++) {
+		flush_work(&works[i].work);
+		destroy_work_on_stack(&works[i].work);
+	}
+
+	n = bridge->n_sensors;
+	ret = ctx.ret;
+	if (ret)
+		goto err_unwind;
+
+	for (i = 0; i < n; i++) {
+		ret = ipu_bridge_register_sensor(&ctx, i);
+		if (ret) {
+			registered = i;
+			released = i + 1;
+			goto err_unwind;
+		}
 	}
 
+	for (i = 0; i < n; i++)
+		acpi_dev_put(ctx.adevs[i]);
+	mutex_destroy(&ctx.lock);
+
 	return 0;
 
-err_unregister_sensors:
+err_unwind:
+	/*
+	 * Sensors below 'registered' are fully set up, the failing one
+	 * released its own resources, the rest hold probe references
+	 * only.
+	 */
+	for (i = released; i < n; i++) {
+		put_device(bridge->sensors[i].csi_dev);
+		acpi_dev_put(bridge->sensors[i].ivsc_adev);
+	}
+	bridge->n_sensors = registered;
 	ipu_bridge_unregister_sensors(bridge);
+	bridge->n_sensors = 0;
+	for (i = 0; i < n; i++)
+		acpi_dev_put(ctx.adevs[i]);
+	mutex_destroy(&ctx.lock);
+
 	return ret;
 }
 
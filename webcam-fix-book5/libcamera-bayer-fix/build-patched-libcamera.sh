@@ -6,7 +6,8 @@
 #   1. Detects the installed libcamera version
 #   2. Installs build dependencies for your distro
 #   3. Clones matching libcamera source from git
-#   4. Applies the bayer order fix patch
+#   4. Applies the bayer order fix patch and vectorizes the software-ISP
+#      10-bit debayer (AVX2/SSSE3, runtime-dispatched, best-effort)
 #   5. Builds libcamera
 #   6. Installs the patched library (with backup of originals)
 #
@@ -581,6 +582,270 @@ PYEOF
     ok "Patch applied successfully."
 }
 
+apply_simd_debayer_patch() {
+    local debayer_cpp="$BUILD_DIR/libcamera/src/libcamera/software_isp/debayer_cpu.cpp"
+
+    if [[ ! -f "$debayer_cpp" ]]; then
+        warn "No software ISP debayer source — skipping SIMD debayer patch."
+        return 0
+    fi
+
+    info "Applying SIMD 10-bit debayer patch..."
+
+    # The stock debayer10P_* loops walk the CSI-2 packed stream byte by
+    # byte, stepping around the fifth (LSB) byte of every 5-byte group
+    # with per-pixel offset arithmetic. Unpacking each line to one byte
+    # per sample first is a pure byte compaction (the stock code
+    # discards the low two bits the same way), which SSSE3/AVX2 do with
+    # a single shuffle at near-memcpy speed — and it leaves the
+    # interpolation loops with uniform indexing the compiler can
+    # vectorize. This is most of libcamera's CPU time on the OV02E10,
+    # which always streams packed 10-bit into the software ISP.
+    #
+    # Everything here is best-effort: if the source doesn't look like
+    # we expect (older tree without software ISP, future refactor), we
+    # keep the stock scalar code. A pristine copy is kept so the build
+    # step can also fall back if the patched file fails to compile.
+    cp "$debayer_cpp" "$debayer_cpp.orig"
+
+    if ! python3 - "$debayer_cpp" << 'PYEOF'
+import sys, re
+
+filepath = sys.argv[1]
+with open(filepath, 'r') as f:
+    content = f.read()
+
+if 'unpackRaw10PMsb' in content:
+    print("SIMD debayer unpack already present")
+    sys.exit(0)
+
+# The replacement bodies feed unpacked 8-bit samples through the same
+# red_/green_/blue_ lookup tables the stock loops use.
+for needle in ('red_[', 'green_[', 'blue_[', 'window_.width'):
+    if needle not in content:
+        print("ERROR: expected '%s' in debayer_cpu.cpp" % needle, file=sys.stderr)
+        sys.exit(1)
+
+helper = '''
+/*
+ * Vectorised unpacking for CSI-2 packed 10-bit input. Dropping every
+ * fifth (LSB) byte of the packed stream yields the same 8-bit MSB
+ * samples the packed loops index their lookup tables with. Kernels are
+ * picked once at runtime via __builtin_cpu_supports(); the scalar path
+ * covers non-x86 builds.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+void unpackRaw10PMsbScalar(uint8_t *dst, const uint8_t *src, int width)
+{
+\tfor (int i = 0; i < width; i++)
+\t\tdst[i] = src[i + (i >> 2)];
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("ssse3")))
+void unpackRaw10PMsbSsse3(uint8_t *dst, const uint8_t *src, int width)
+{
+\t/*
+\t * Pick the 4 MSB bytes out of each 5-byte group: 15 packed bytes
+\t * yield 12 samples per shuffle. The 16-byte store runs 4 bytes
+\t * past the samples produced; the destination is padded and the
+\t * next iteration (or the tail) rewrites them.
+\t */
+\tconst __m128i mask = _mm_setr_epi8(0, 1, 2, 3, 5, 6, 7, 8,
+\t\t\t\t\t   10, 11, 12, 13, -1, -1, -1, -1);
+\tint i = 0;
+
+\tfor (; i + 12 <= width; i += 12) {
+\t\t__m128i v = _mm_loadu_si128(
+\t\t\treinterpret_cast<const __m128i *>(src + i + (i >> 2)));
+\t\t_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+\t\t\t\t _mm_shuffle_epi8(v, mask));
+\t}
+
+\tunpackRaw10PMsbScalar(dst + i, src + i + (i >> 2), width - i);
+}
+
+__attribute__((target("avx2")))
+void unpackRaw10PMsbAvx2(uint8_t *dst, const uint8_t *src, int width)
+{
+\t/*
+\t * Same shuffle in both 128-bit lanes, lanes loaded 15 packed
+\t * bytes apart: 30 bytes in, 24 samples out per iteration.
+\t */
+\tconst __m128i mask = _mm_setr_epi8(0, 1, 2, 3, 5, 6, 7, 8,
+\t\t\t\t\t   10, 11, 12, 13, -1, -1, -1, -1);
+\tconst __m256i mask2 = _mm256_broadcastsi128_si256(mask);
+\tint i = 0;
+
+\tfor (; i + 24 <= width; i += 24) {
+\t\tconst uint8_t *s = src + i + (i >> 2);
+\t\t__m256i v = _mm256_castsi128_si256(_mm_loadu_si128(
+\t\t\treinterpret_cast<const __m128i *>(s)));
+\t\tv = _mm256_inserti128_si256(v, _mm_loadu_si128(
+\t\t\treinterpret_cast<const __m128i *>(s + 15)), 1);
+\t\tv = _mm256_shuffle_epi8(v, mask2);
+\t\t_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+\t\t\t\t _mm256_castsi256_si128(v));
+\t\t_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 12),
+\t\t\t\t _mm256_extracti128_si256(v, 1));
+\t}
+
+\tunpackRaw10PMsbScalar(dst + i, src + i + (i >> 2), width - i);
+}
+
+#endif /* x86 */
+
+void unpackRaw10PMsb(uint8_t *dst, const uint8_t *src, int width)
+{
+\tstatic void (*impl)(uint8_t *, const uint8_t *, int) = nullptr;
+
+\tif (!impl) {
+#if defined(__x86_64__) || defined(__i386__)
+\t\tif (__builtin_cpu_supports("avx2"))
+\t\t\timpl = unpackRaw10PMsbAvx2;
+\t\telse if (__builtin_cpu_supports("ssse3"))
+\t\t\timpl = unpackRaw10PMsbSsse3;
+\t\telse
+#endif
+\t\t\timpl = unpackRaw10PMsbScalar;
+\t}
+
+\timpl(dst, src, width);
+}
+
+/*
+ * Unpack one line with one neighbouring sample on each side: index -1
+ * and width come from the 2 bytes of line padding the caller already
+ * guarantees (the packed loops read curr[x - 2] and curr[x + 2] into
+ * the same padding).
+ */
+const uint8_t *unpackRaw10PLine(const uint8_t *src, int width, int slot)
+{
+\tstatic thread_local std::vector<uint8_t> bufs[3];
+\tstd::vector<uint8_t> &buf = bufs[slot];
+
+\tif (static_cast<int>(buf.size()) < width + 20)
+\t\tbuf.resize(width + 20);
+
+\tuint8_t *dst = buf.data() + 1;
+
+\tdst[-1] = src[-2];
+\tunpackRaw10PMsb(dst, src, width);
+\tdst[width] = src[(width * 5) >> 2];
+
+\treturn dst;
+}
+
+} /* namespace */
+'''.replace('\\t', '\t')
+
+prologue = (
+    'void DebayerCpu::debayer10P_PHASE_BGR888(uint8_t *dst, const uint8_t *src[])\n'
+    '{\n'
+    '\tconst int width = window_.width;\n'
+    '\tconst uint8_t *prev = unpackRaw10PLine(src[0], width, 0);\n'
+    '\tconst uint8_t *curr = unpackRaw10PLine(src[1], width, 1);\n'
+    '\tconst uint8_t *next = unpackRaw10PLine(src[2], width, 2);\n'
+    '\n'
+    '\tfor (int x = 0; x < width; x += 2) {\n'
+)
+epilogue = '\t}\n}'
+
+# Two pixels per iteration; phase names follow the stock functions
+# (first letter = colour of even columns on this row).
+loops = {
+    'BGBG': (
+        '\t\t/* Blue */\n'
+        '\t\t*dst++ = blue_[curr[x]];\n'
+        '\t\t*dst++ = green_[(prev[x] + curr[x - 1] + curr[x + 1] + next[x]) / 4];\n'
+        '\t\t*dst++ = red_[(prev[x - 1] + prev[x + 1] + next[x - 1] + next[x + 1]) / 4];\n'
+        '\t\t/* Green on a blue row */\n'
+        '\t\t*dst++ = blue_[(curr[x] + curr[x + 2]) / 2];\n'
+        '\t\t*dst++ = green_[curr[x + 1]];\n'
+        '\t\t*dst++ = red_[(prev[x + 1] + next[x + 1]) / 2];\n'
+    ),
+    'GBGB': (
+        '\t\t/* Green on a blue row */\n'
+        '\t\t*dst++ = blue_[(curr[x - 1] + curr[x + 1]) / 2];\n'
+        '\t\t*dst++ = green_[curr[x]];\n'
+        '\t\t*dst++ = red_[(prev[x] + next[x]) / 2];\n'
+        '\t\t/* Blue */\n'
+        '\t\t*dst++ = blue_[curr[x + 1]];\n'
+        '\t\t*dst++ = green_[(prev[x + 1] + curr[x] + curr[x + 2] + next[x + 1]) / 4];\n'
+        '\t\t*dst++ = red_[(prev[x] + prev[x + 2] + next[x] + next[x + 2]) / 4];\n'
+    ),
+    'GRGR': (
+        '\t\t/* Green on a red row */\n'
+        '\t\t*dst++ = blue_[(prev[x] + next[x]) / 2];\n'
+        '\t\t*dst++ = green_[curr[x]];\n'
+        '\t\t*dst++ = red_[(curr[x - 1] + curr[x + 1]) / 2];\n'
+        '\t\t/* Red */\n'
+        '\t\t*dst++ = blue_[(prev[x] + prev[x + 2] + next[x] + next[x + 2]) / 4];\n'
+        '\t\t*dst++ = green_[(prev[x + 1] + curr[x] + curr[x + 2] + next[x + 1]) / 4];\n'
+        '\t\t*dst++ = red_[curr[x + 1]];\n'
+    ),
+    'RGRG': (
+        '\t\t/* Red */\n'
+        '\t\t*dst++ = blue_[(prev[x - 1] + prev[x + 1] + next[x - 1] + next[x + 1]) / 4];\n'
+        '\t\t*dst++ = green_[(prev[x] + curr[x - 1] + curr[x + 1] + next[x]) / 4];\n'
+        '\t\t*dst++ = red_[curr[x]];\n'
+        '\t\t/* Green on a red row */\n'
+        '\t\t*dst++ = blue_[(prev[x + 1] + next[x + 1]) / 2];\n'
+        '\t\t*dst++ = green_[curr[x + 1]];\n'
+        '\t\t*dst++ = red_[(curr[x] + curr[x + 2]) / 2];\n'
+    ),
+}
+
+# Check every function body is where we expect it before touching any.
+matches = {}
+for phase in loops:
+    pat = re.compile(
+        r'void DebayerCpu::debayer10P_' + phase +
+        r'_BGR888\(uint8_t \*dst, const uint8_t \*src\[\]\)\n\{\n.*?\n\}',
+        re.S)
+    m = pat.search(content)
+    if not m:
+        print("ERROR: debayer10P_%s_BGR888 not found with expected signature"
+              % phase, file=sys.stderr)
+        sys.exit(1)
+    matches[phase] = m
+
+for phase, loop in loops.items():
+    pat = re.compile(
+        r'void DebayerCpu::debayer10P_' + phase +
+        r'_BGR888\(uint8_t \*dst, const uint8_t \*src\[\]\)\n\{\n.*?\n\}',
+        re.S)
+    body = prologue.replace('PHASE', phase) + loop + epilogue
+    content = pat.sub(lambda _: body, content, count=1)
+    print("Rewrote debayer10P_%s_BGR888 over unpacked samples" % phase)
+
+# Insert the unpack helpers after the last #include
+includes = list(re.finditer(r'^#include\s+[<"].*[>"]', content, re.M))
+if not includes:
+    print("ERROR: no #include lines found", file=sys.stderr)
+    sys.exit(1)
+pos = content.find('\n', includes[-1].start()) + 1
+content = content[:pos] + helper + content[pos:]
+print("Inserted SIMD unpack kernels (AVX2/SSSE3/scalar, runtime-dispatched)")
+
+with open(filepath, 'w') as f:
+    f.write(content)
+PYEOF
+    then
+        warn "SIMD debayer patch did not apply — keeping stock scalar debayer."
+        mv "$debayer_cpp.orig" "$debayer_cpp"
+        return 0
+    fi
+
+    ok "SIMD debayer patch applied."
+}
+
 # ─── Detect meson build options from installed libcamera ─────────────
 detect_build_options() {
     MESON_OPTIONS=(
@@ -789,6 +1054,12 @@ else
 fi
 echo ""
 
+# Step 4c: Vectorize the software-ISP 10-bit debayer. The OV02E10
+# always streams packed 10-bit raw into the CPU debayer, which is where
+# most of libcamera's CPU time goes.
+apply_simd_debayer_patch
+echo ""
+
 # Step 5: Verify patch
 info "Verifying patch..."
 if grep -q 'inputBayer.order' "$BUILD_DIR/libcamera/src/libcamera/pipeline/simple/simple.cpp"; then
@@ -796,6 +1067,10 @@ if grep -q 'inputBayer.order' "$BUILD_DIR/libcamera/src/libcamera/pipeline/simpl
 else
     die "Patch verification failed — inputBayer.order not found in patched source."
 fi
+DEBAYER_CPP="$BUILD_DIR/libcamera/src/libcamera/software_isp/debayer_cpu.cpp"
+if grep -q 'unpackRaw10PMsb' "$DEBAYER_CPP" 2>/dev/null; then
+    ok "SIMD 10-bit debayer unpack present."
+fi
 echo ""
 
 # Step 6: Configure and build
@@ -806,7 +1081,17 @@ cd "$BUILD_DIR/libcamera"
 meson setup builddir "${MESON_OPTIONS[@]}" 2>&1 | tail -20
 
 info "Building (this may take 5-10 minutes)..."
-ninja -C builddir 2>&1 | tail -5
+if ! ninja -C builddir 2>&1 | tail -5; then
+    # The SIMD debayer patch targets code that upstream may restructure;
+    # a build break there must not take the bayer fix down with it.
+    if [[ -f "$DEBAYER_CPP.orig" ]] && ! cmp -s "$DEBAYER_CPP" "$DEBAYER_CPP.orig"; then
+        warn "Build failed — retrying without the SIMD debayer patch..."
+        mv "$DEBAYER_CPP.orig" "$DEBAYER_CPP"
+        ninja -C builddir 2>&1 | tail -5
+    else
+        die "Build failed."
+    fi
+fi
 
 ok "Build completed."
 echo ""
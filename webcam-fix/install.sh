@@ -516,6 +516,20 @@ echo "  ✓ v4l2-relayd configured for IPU6"
 sudo install -m 755 "$SCRIPT_DIR/v4l2-relayd-detect-resolution.sh" /usr/local/sbin/v4l2-relayd-detect-resolution.sh
 echo "  ✓ Resolution auto-detection script installed"
 
+# Build the native prober when a compiler is available — it answers
+# from a per-device cache on later boots instead of spinning up a
+# GStreamer pipeline, shaving startup time off the relay service.
+if command -v gcc &>/dev/null; then
+    if gcc -O2 -Wall -o /tmp/v4l2-relayd-detect-resolution \
+        "$SCRIPT_DIR/v4l2-relayd-detect-resolution.c" 2>/dev/null; then
+        sudo install -m 755 /tmp/v4l2-relayd-detect-resolution /usr/local/sbin/v4l2-relayd-detect-resolution
+        rm -f /tmp/v4l2-relayd-detect-resolution
+        echo "  ✓ Native resolution prober built and installed"
+    else
+        echo "  ⚠ Native prober build failed, using script-only detection"
+    fi
+fi
+
 # ──────────────────────────────────────────────
 # [9/13] Harden v4l2-relayd service
 # ──────────────────────────────────────────────
@@ -0,0 +1,265 @@
+/*
+ * v4l2-relayd-detect-resolution — native camera resolution prober
+ *
+ * Replaces the gst-launch probe in v4l2-relayd-detect-resolution.sh
+ * on the boot path: a full GStreamer pipeline spin-up plus text
+ * parsing costs hundreds of milliseconds before the relay can start.
+ * This queries the capture device directly with VIDIOC_ENUM_FMT /
+ * VIDIOC_ENUM_FRAMESIZES and caches the answer keyed on the device
+ * identity (bus_info + card from QUERYCAP), so subsequent boots skip
+ * the probe entirely unless the camera or HAL changed.
+ *
+ * Writes WIDTH=/HEIGHT= to /run/v4l2-relayd-resolution.env in the
+ * EnvironmentFile format the service override expects. Exits non-zero
+ * when no enumerable capture device is found so the shell script can
+ * fall back to the icamerasrc caps probe.
+ *
+ * Build:  gcc -O2 -Wall -o v4l2-relayd-detect-resolution \
+ *             v4l2-relayd-detect-resolution.c
+ *
+ * Usage:  v4l2-relayd-detect-resolution [/dev/videoN]
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ENV_FILE	"/run/v4l2-relayd-resolution.env"
+#define CACHE_FILE	"/var/cache/v4l2-relayd-resolution"
+#define DEFAULT_WIDTH	1920
+#define DEFAULT_HEIGHT	1080
+
+/* Sensor modes above this are crops/stills we never relay */
+#define MAX_WIDTH	1920
+#define MAX_HEIGHT	1080
+
+/* Formats the relay pipeline can take, most preferred first */
+static const uint32_t preferred_fmts[] = {
+	V4L2_PIX_FMT_NV12,
+	V4L2_PIX_FMT_YUYV,
+	V4L2_PIX_FMT_UYVY,
+};
+
+/* Identity key for the cache: bus_info + card uniquely name the
+ * camera and survive /dev/videoN renumbering across boots. */
+static void device_key(int fd, char *key, size_t len)
+{
+	struct v4l2_capability cap;
+
+	memset(&cap, 0, sizeof(cap));
+	if (ioctl(fd, VIDIOC_QUERYCAP, &cap) == 0)
+		snprintf(key, len, "%s|%s", cap.bus_info, cap.card);
+	else
+		snprintf(key, len, "unknown");
+}
+
+static int write_env(int width, int height)
+{
+	FILE *f = fopen(ENV_FILE, "w");
+
+	if (!f) {
+		fprintf(stderr, "Cannot write %s: %s\n", ENV_FILE,
+			strerror(errno));
+		return -1;
+	}
+	fprintf(f, "WIDTH=%d\nHEIGHT=%d\n", width, height);
+	fclose(f);
+	fprintf(stderr, "Detected resolution: %dx%d\n", width, height);
+	return 0;
+}
+
+/* Cache line: "<key> <width> <height>". Returns 1 on a key match. */
+static int cache_lookup(const char *key, int *width, int *height)
+{
+	char line[256], ckey[192];
+	FILE *f = fopen(CACHE_FILE, "r");
+
+	if (!f)
+		return 0;
+	if (!fgets(line, sizeof(line), f)) {
+		fclose(f);
+		return 0;
+	}
+	fclose(f);
+	if (sscanf(line, "%191[^\t]\t%d %d", ckey, width, height) != 3)
+		return 0;
+	return strcmp(ckey, key) == 0 &&
+	       *width > 0 && *height > 0;
+}
+
+static void cache_store(const char *key, int width, int height)
+{
+	char tmp[] = CACHE_FILE ".XXXXXX";
+	int fd = mkstemp(tmp);
+	FILE *f;
+
+	if (fd < 0)
+		return;
+	f = fdopen(fd, "w");
+	if (!f) {
+		close(fd);
+		unlink(tmp);
+		return;
+	}
+	fprintf(f, "%s\t%d %d\n", key, width, height);
+	fchmod(fd, 0644);
+	fclose(f);
+	if (rename(tmp, CACHE_FILE) < 0)
+		unlink(tmp);
+}
+
+/* Largest relayable discrete frame size for fmt, 0 if none. */
+static long best_size_for_fmt(int fd, uint32_t fmt, int *width,
+			      int *height)
+{
+	long best = 0;
+
+	for (uint32_t i = 0; ; i++) {
+		struct v4l2_frmsizeenum fs;
+
+		memset(&fs, 0, sizeof(fs));
+		fs.index = i;
+		fs.pixel_format = fmt;
+		if (ioctl(fd, VIDIOC_ENUM_FRAMESIZES, &fs) < 0)
+			break;
+
+		if (fs.type != V4L2_FRMSIZE_TYPE_DISCRETE) {
+			/* Stepwise/continuous: take the clamped max */
+			int w = fs.stepwise.max_width;
+			int h = fs.stepwise.max_height;
+
+			if (w > MAX_WIDTH)
+				w = MAX_WIDTH;
+			if (h > MAX_HEIGHT)
+				h = MAX_HEIGHT;
+			if ((long)w * h > best) {
+				best = (long)w * h;
+				*width = w;
+				*height = h;
+			}
+			break;
+		}
+
+		if (fs.discrete.width > MAX_WIDTH ||
+		    fs.discrete.height > MAX_HEIGHT)
+			continue;
+		if ((long)fs.discrete.width * fs.discrete.height >
+		    best) {
+			best = (long)fs.discrete.width *
+			       fs.discrete.height;
+			*width = fs.discrete.width;
+			*height = fs.discrete.height;
+		}
+	}
+	return best;
+}
+
+/* Probe the device: preferred format with the largest relayable
+ * size wins; any enumerable format is better than nothing. */
+static int probe_device(int fd, int *width, int *height)
+{
+	for (size_t p = 0;
+	     p < sizeof(preferred_fmts) / sizeof(preferred_fmts[0]);
+	     p++) {
+		if (best_size_for_fmt(fd, preferred_fmts[p], width,
+				      height) > 0)
+			return 0;
+	}
+
+	for (uint32_t i = 0; ; i++) {
+		struct v4l2_fmtdesc fmt;
+
+		memset(&fmt, 0, sizeof(fmt));
+		fmt.index = i;
+		fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		if (ioctl(fd, VIDIOC_ENUM_FMT, &fmt) < 0)
+			break;
+		if (best_size_for_fmt(fd, fmt.pixelformat, width,
+				      height) > 0)
+			return 0;
+	}
+	return -1;
+}
+
+/* A usable source: real capture hardware, not our own loopback. */
+static int is_capture_source(int fd)
+{
+	struct v4l2_capability cap;
+
+	memset(&cap, 0, sizeof(cap));
+	if (ioctl(fd, VIDIOC_QUERYCAP, &cap) < 0)
+		return 0;
+	if (!(cap.device_caps & V4L2_CAP_VIDEO_CAPTURE))
+		return 0;
+	if (strcmp((const char *)cap.driver, "v4l2 loopback") == 0)
+		return 0;
+	return 1;
+}
+
+static int open_source(const char *arg)
+{
+	if (arg) {
+		int fd = open(arg, O_RDWR | O_NONBLOCK);
+
+		if (fd < 0)
+			fprintf(stderr, "Cannot open %s: %s\n", arg,
+				strerror(errno));
+		return fd;
+	}
+
+	for (int i = 0; i < 64; i++) {
+		char path[32];
+		int fd;
+
+		snprintf(path, sizeof(path), "/dev/video%d", i);
+		fd = open(path, O_RDWR | O_NONBLOCK);
+		if (fd < 0)
+			continue;
+		if (is_capture_source(fd)) {
+			fprintf(stderr, "Probing %s\n", path);
+			return fd;
+		}
+		close(fd);
+	}
+	return -1;
+}
+
+int main(int argc, char **argv)
+{
+	char key[192];
+	int width = 0, height = 0;
+	int fd = open_source(argc > 1 ? argv[1] : NULL);
+
+	if (fd < 0) {
+		fprintf(stderr, "No enumerable capture device found\n");
+		return 1;
+	}
+
+	device_key(fd, key, sizeof(key));
+
+	if (cache_lookup(key, &width, &height)) {
+		close(fd);
+		return write_env(width, height) ? 1 : 0;
+	}
+
+	if (probe_device(fd, &width, &height) < 0) {
+		close(fd);
+		fprintf(stderr, "Device enumerates no frame sizes\n");
+		return 1;
+	}
+	close(fd);
+
+	if (width <= 0 || height <= 0) {
+		width = DEFAULT_WIDTH;
+		height = DEFAULT_HEIGHT;
+	}
+
+	cache_store(key, width, height);
+	return write_env(width, height) ? 1 : 0;
+}
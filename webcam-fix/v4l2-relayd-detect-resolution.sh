@@ -18,6 +18,15 @@ ENV_FILE="/run/v4l2-relayd-resolution.env"
 SHM_KEY="0x0043414d"
 DEFAULT_WIDTH=1920
 DEFAULT_HEIGHT=1080
+PROBER="/usr/local/sbin/v4l2-relayd-detect-resolution"
+
+# Fast path: the native prober enumerates the capture device directly
+# (and caches per device identity), skipping the ~0.5s GStreamer
+# spin-up below. Falls through when the device can't be enumerated
+# (icamerasrc-only setups).
+if [[ -x "$PROBER" ]] && "$PROBER"; then
+    exit 0
+fi
 
 # Clean any stale SHM from previous runs
 ipcrm -M "$SHM_KEY" 2>/dev/null || true